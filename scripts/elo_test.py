@@ -5,6 +5,11 @@ Requires: cutechess-cli in PATH, c64chess.exe built, and a reference engine.
 
 Usage:
     python scripts/elo_test.py [--rounds 200] [--opponent tscp.exe]
+
+UCI options can be set on either side, e.g. to measure one forward pruning
+technique in self-play:
+    python scripts/elo_test.py --opponent build/c64chess.exe \
+        --opponent-option Futility=false
 """
 
 import argparse
@@ -18,6 +23,10 @@ def main():
     parser.add_argument("--opponent", default="tscp.exe", help="Reference engine path")
     parser.add_argument("--tc", default="1+0.1", help="Time control (seconds+increment)")
     parser.add_argument("--openings", default="", help="Opening book file (EPD format)")
+    parser.add_argument("--option", action="append", default=[], metavar="NAME=VALUE",
+                        help="UCI option for C64Chess (repeatable)")
+    parser.add_argument("--opponent-option", action="append", default=[], metavar="NAME=VALUE",
+                        help="UCI option for the opponent (repeatable)")
     args = parser.parse_args()
 
     engine_path = os.path.join("build", "c64chess.exe")
@@ -25,10 +34,17 @@ def main():
         print(f"Error: {engine_path} not found. Run 'make pc' first.")
         sys.exit(1)
 
+    for opt in args.option + args.opponent_option:
+        if "=" not in opt:
+            print(f"Error: option '{opt}' is not NAME=VALUE.")
+            sys.exit(1)
+
     cmd = [
         "cutechess-cli",
         "-engine", f"cmd={engine_path}", "proto=uci", "name=C64Chess",
+        *[f"option.{opt}" for opt in args.option],
         "-engine", f"cmd={args.opponent}", "proto=uci", "name=Opponent",
+        *[f"option.{opt}" for opt in args.opponent_option],
         "-each", f"tc={args.tc}",
         "-rounds", str(args.rounds),
         "-games", "2",
@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""
+Root-splitting search coordinator.
+Speaks UCI on stdin/stdout like the engine itself, but spreads each search
+over several worker processes: N copies of the engine started over pipes.
+The root moves come from the workers ("go perft 1"), each root move is
+searched as its own job ("go depth D searchmoves <move>"), and the
+per-move scores are gathered into one info/bestmove stream.
+
+Iterative deepening runs at the coordinator. After each depth, only the
+root moves scoring within a window of the best score are searched again;
+the window starts wide and halves every iteration down to a floor, and a
+move that fell out comes back if the best score drops to within reach of
+its last score. Workers need nothing beyond the normal UCI loop.
+
+Usage:
+    python scripts/root_split.py [--workers 4] [--engine build/c64chess.exe]
+
+--engine is a command line, so workers can also run elsewhere, e.g.
+--engine "ssh host ./c64chess.exe". A quick check on localhost:
+    printf "position startpos\\ngo depth 6\\nquit\\n" | python scripts/root_split.py
+"""
+
+import argparse
+import os
+import queue
+import shlex
+import subprocess
+import sys
+import threading
+import time
+
+INITIAL_WINDOW = 400   # centipawns below the best score still re-searched
+MIN_WINDOW = 50
+MATE_SCORE = 29000 - 100
+
+
+class Worker:
+    """One engine process, driven line by line over its pipes."""
+
+    def __init__(self, cmd):
+        self.proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                     universal_newlines=True, bufsize=1)
+        self.send("uci")
+        self.read_until("uciok")
+
+    def send(self, line):
+        self.proc.stdin.write(line + "\n")
+        self.proc.stdin.flush()
+
+    def read_until(self, prefix):
+        """Lines up to and including the first one starting with prefix"""
+        lines = []
+        while True:
+            line = self.proc.stdout.readline()
+            if not line:
+                raise RuntimeError("worker exited")
+            line = line.strip()
+            lines.append(line)
+            if line.startswith(prefix):
+                return lines
+
+    def root_moves(self, position):
+        self.send(position)
+        self.send("go perft 1")
+        lines = self.read_until("Nodes searched")
+        return [l.split(":")[0] for l in lines if ":" in l and not l.startswith("Nodes")]
+
+    def search(self, position, move, depth, movetime):
+        """(depth reached, score, nodes, pv) of one root move"""
+        self.send(position)
+        go = "go depth %d" % depth
+        if movetime is not None:
+            go += " movetime %d" % max(1, movetime)
+        self.send(go + " searchmoves " + move)
+        reached, score, nodes, pv = 0, None, 0, [move]
+        for line in self.read_until("bestmove"):
+            tokens = line.split()
+            if not tokens or tokens[0] != "info" or "score" not in tokens:
+                continue
+            reached = int(tokens[tokens.index("depth") + 1])
+            score = int(tokens[tokens.index("score") + 2])
+            nodes = int(tokens[tokens.index("nodes") + 1])
+            if "pv" in tokens:
+                pv = tokens[tokens.index("pv") + 1:]
+        return reached, score, nodes, pv
+
+    def quit(self):
+        try:
+            self.send("quit")
+            self.proc.wait(timeout=5)
+        except Exception:
+            self.proc.kill()
+        self.proc.stdin.close()
+        self.proc.stdout.close()
+
+
+class Coordinator:
+    def __init__(self, cmd, workers):
+        self.workers = [Worker(cmd) for _ in range(workers)]
+        self.position = "position startpos"
+
+    def broadcast(self, line):
+        for w in self.workers:
+            w.send(line)
+
+    def sync(self):
+        for w in self.workers:
+            w.send("isready")
+            w.read_until("readyok")
+
+    def white_to_move(self):
+        tokens = self.position.split()
+        white = True
+        if len(tokens) > 2 and tokens[1] == "fen":
+            white = tokens[3] == "w"
+        if "moves" in tokens:
+            if (len(tokens) - tokens.index("moves") - 1) % 2:
+                white = not white
+        return white
+
+    def run_jobs(self, moves, depth, deadline):
+        """Search each move on whichever worker is free; returns the results
+        of the jobs that finished (all of them unless time ran out)"""
+        jobs = queue.Queue()
+        for m in moves:
+            jobs.put(m)
+        results = {}
+        lock = threading.Lock()
+
+        def work(worker):
+            while True:
+                try:
+                    m = jobs.get_nowait()
+                except queue.Empty:
+                    return
+                budget = None
+                if deadline is not None:
+                    budget = int((deadline - time.time()) * 1000)
+                    if budget <= 0:
+                        return
+                r = worker.search(self.position, m, depth, budget)
+                with lock:
+                    results[m] = r
+
+        threads = [threading.Thread(target=work, args=(w,)) for w in self.workers]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        return results
+
+    def go(self, max_depth, movetime):
+        start = time.time()
+        deadline = start + movetime / 1000.0 if movetime else None
+        moves = self.workers[0].root_moves(self.position)
+        if not moves:
+            print("bestmove 0000", flush=True)
+            return
+
+        scores = {}          # last score of each root move
+        pvs = {}
+        total_nodes = 0
+        window = INITIAL_WINDOW
+        best = moves[0]
+
+        for depth in range(1, max_depth + 1):
+            if scores:
+                floor = scores[best] - window
+                todo = [m for m in moves if scores[m] >= floor]
+            else:
+                todo = list(moves)
+
+            results = self.run_jobs(todo, depth, deadline)
+            total_nodes += sum(r[2] for r in results.values())
+            complete = len(results) == len(todo) and \
+                all(r[0] >= depth and r[1] is not None for r in results.values())
+            if not complete:
+                break       # out of time: keep the last full iteration
+
+            for m, (_, score, _, pv) in results.items():
+                scores[m] = score
+                pvs[m] = pv
+            # Only a move searched at this depth can be reported for it: a
+            # skipped move's score is from a shallower search
+            best = max(results, key=lambda m: scores[m])
+            moves.sort(key=lambda m: -scores[m])
+
+            elapsed = int((time.time() - start) * 1000)
+            nps = total_nodes * 1000 // elapsed if elapsed > 0 else 0
+            print("info depth %d score cp %d nodes %d time %d nps %d pv %s" %
+                  (depth, scores[best], total_nodes, elapsed, nps, " ".join(pvs[best])),
+                  flush=True)
+
+            window = max(MIN_WINDOW, window // 2)
+            if abs(scores[best]) > MATE_SCORE:
+                break
+            if deadline is not None and time.time() >= deadline:
+                break
+
+        print("bestmove %s" % best, flush=True)
+
+    def cmd_go(self, line):
+        tokens = line.split()[1:]
+        args = {}
+        for i in range(len(tokens) - 1):
+            if tokens[i] in ("depth", "movetime", "wtime", "btime", "winc", "binc"):
+                args[tokens[i]] = int(tokens[i + 1])
+        depth = min(args.get("depth", 20), 60)
+        movetime = args.get("movetime")
+        if movetime is None and ("wtime" in args or "btime" in args):
+            # Same rule as the engine: 1/20 of the clock plus most of the increment
+            white = self.white_to_move()
+            our_time = args.get("wtime" if white else "btime", 0)
+            our_inc = args.get("winc" if white else "binc", 0)
+            movetime = our_time // 20 + our_inc * 3 // 4 if our_time > 0 else 1000
+            if our_time > 100:
+                movetime = min(movetime, our_time - 50)
+        self.go(depth, movetime)
+
+    def loop(self):
+        for line in sys.stdin:
+            line = line.strip()
+            if line == "uci":
+                print("id name C64Chess root-split x%d" % len(self.workers))
+                print("id author David")
+                print("uciok", flush=True)
+            elif line == "isready":
+                self.sync()
+                print("readyok", flush=True)
+            elif line == "ucinewgame" or line.startswith("setoption"):
+                self.broadcast(line)
+            elif line.startswith("position"):
+                self.position = line
+            elif line.startswith("go"):
+                self.cmd_go(line)
+            elif line == "quit":
+                break
+
+    def quit(self):
+        for w in self.workers:
+            w.quit()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Root-splitting UCI coordinator")
+    parser.add_argument("--workers", type=int, default=4, help="Number of worker processes")
+    parser.add_argument("--engine", default=os.path.join("build", "c64chess.exe"),
+                        help="Worker command line")
+    args = parser.parse_args()
+
+    cmd = shlex.split(args.engine)
+    if len(cmd) == 1 and not os.path.exists(cmd[0]):
+        print(f"Error: {cmd[0]} not found. Run 'make pc' first.", file=sys.stderr)
+        sys.exit(1)
+
+    coordinator = Coordinator(cmd, args.workers)
+    try:
+        coordinator.loop()
+    finally:
+        coordinator.quit()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#include "bitboard.h"
+
+#ifdef USE_BITBOARDS
+
+/*
+ * Bitboard attack tables, built once by bitboard_init().
+ * Slider attacks use "fancy" magic bitboards: the relevant occupancy of a
+ * square is multiplied by a magic constant and shifted down to index a
+ * per-square slice of a shared attack table.
+ */
+
+Bitboard bb_knight_attacks[64];
+Bitboard bb_king_attacks[64];
+Bitboard bb_pawn_attacks[2][64];
+
+Magic bb_rook_magics[64];
+Magic bb_bishop_magics[64];
+
+/* Shared attack storage: sum over squares of 2^(relevant bits) */
+static Bitboard rook_table[102400];
+static Bitboard bishop_table[5248];
+
+/* Magic multipliers, found offline by random trial (sparse random
+ * candidates verified collision-free for every occupancy subset) */
+static const Bitboard rook_magic_numbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+static const Bitboard bishop_magic_numbers[64] = {
+    0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+    0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+    0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+    0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+    0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
+
+static const s8 rook_dirs[4][2]   = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+static const s8 bishop_dirs[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+/* Walk the four rays from sq (rank/file steps), stopping at the first
+ * occupied square. With edges = 0 the board edge square is excluded,
+ * giving the relevant-occupancy mask. */
+static Bitboard slider_rays(u8 sq, Bitboard occ, const s8 dirs[4][2], u8 edges) {
+    Bitboard attacks = 0;
+    s8 r, f, nr, nf;
+    u8 d;
+
+    for (d = 0; d < 4; d++) {
+        r = (s8)(sq >> 3) + dirs[d][0];
+        f = (s8)(sq & 7) + dirs[d][1];
+        while (r >= 0 && r < 8 && f >= 0 && f < 8) {
+            if (!edges) {
+                nr = r + dirs[d][0];
+                nf = f + dirs[d][1];
+                if (nr < 0 || nr > 7 || nf < 0 || nf > 7) break;
+            }
+            attacks |= BB_SQ(r * 8 + f);
+            if (occ & BB_SQ(r * 8 + f)) break;
+            r += dirs[d][0];
+            f += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+static void init_magics(Magic *magics, const Bitboard *numbers,
+                        Bitboard *table, const s8 dirs[4][2]) {
+    Bitboard *next = table;
+    Bitboard subset;
+    u8 sq;
+
+    for (sq = 0; sq < 64; sq++) {
+        Magic *m = &magics[sq];
+        m->mask = slider_rays(sq, 0, dirs, 0);
+        m->magic = numbers[sq];
+        m->shift = (u8)(64 - bb_popcount(m->mask));
+        m->attacks = next;
+
+        /* Enumerate every subset of the mask (Carry-Rippler trick) */
+        subset = 0;
+        do {
+            m->attacks[(subset * m->magic) >> m->shift] =
+                slider_rays(sq, subset, dirs, 1);
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        next += (Bitboard)1 << (64 - m->shift);
+    }
+}
+
+/* Set the bit for (rank, file) if it is on the board */
+static Bitboard bb_from_rf(s8 r, s8 f) {
+    if (r < 0 || r > 7 || f < 0 || f > 7) return 0;
+    return BB_SQ(r * 8 + f);
+}
+
+void bitboard_init(void) {
+    static const s8 knight_steps[8][2] = {
+        {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}
+    };
+    u8 sq, i;
+    s8 r, f;
+
+    for (sq = 0; sq < 64; sq++) {
+        r = (s8)(sq >> 3);
+        f = (s8)(sq & 7);
+
+        bb_knight_attacks[sq] = 0;
+        for (i = 0; i < 8; i++) {
+            bb_knight_attacks[sq] |= bb_from_rf(r + knight_steps[i][0],
+                                                f + knight_steps[i][1]);
+        }
+
+        bb_king_attacks[sq] = 0;
+        for (i = 0; i < 4; i++) {
+            bb_king_attacks[sq] |= bb_from_rf(r + rook_dirs[i][0], f + rook_dirs[i][1]);
+            bb_king_attacks[sq] |= bb_from_rf(r + bishop_dirs[i][0], f + bishop_dirs[i][1]);
+        }
+
+        bb_pawn_attacks[WHITE][sq] = bb_from_rf(r + 1, f - 1) | bb_from_rf(r + 1, f + 1);
+        bb_pawn_attacks[BLACK][sq] = bb_from_rf(r - 1, f - 1) | bb_from_rf(r - 1, f + 1);
+    }
+
+    init_magics(bb_rook_magics, rook_magic_numbers, rook_table, rook_dirs);
+    init_magics(bb_bishop_magics, bishop_magic_numbers, bishop_table, bishop_dirs);
+}
+
+#endif /* USE_BITBOARDS */
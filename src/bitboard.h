@@ -0,0 +1,70 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "types.h"
+
+#ifdef USE_BITBOARDS
+
+/*
+ * Bitboards (PC build only)
+ * 64-bit square sets, bit n = SQ_INDEX64 square n (a1 = 0, h8 = 63).
+ * GameState keeps per-piece and per-color sets alongside the 0x88 board;
+ * attack detection and move generation use them on PC, while the C64
+ * build stays on 0x88.
+ */
+
+typedef u64 Bitboard;
+
+#define BB_SQ(s)     ((Bitboard)1 << (s))
+#define BB_RANK_1    0x00000000000000FFULL
+#define BB_RANK_2    0x000000000000FF00ULL
+#define BB_RANK_7    0x00FF000000000000ULL
+#define BB_RANK_8    0xFF00000000000000ULL
+
+/* Magic bitboard lookup entry for one square */
+typedef struct {
+    Bitboard  mask;     /* relevant occupancy (ray squares minus edges) */
+    Bitboard  magic;    /* multiplier mapping occupancy -> table index */
+    Bitboard *attacks;  /* this square's slice of the shared table */
+    u8        shift;    /* 64 - popcount(mask) */
+} Magic;
+
+extern Bitboard bb_knight_attacks[64];
+extern Bitboard bb_king_attacks[64];
+extern Bitboard bb_pawn_attacks[2][64];  /* [color][sq]: squares attacked */
+
+extern Magic bb_rook_magics[64];
+extern Magic bb_bishop_magics[64];
+
+static inline Bitboard bb_rook_attacks(u8 sq, Bitboard occ) {
+    const Magic *m = &bb_rook_magics[sq];
+    return m->attacks[((occ & m->mask) * m->magic) >> m->shift];
+}
+
+static inline Bitboard bb_bishop_attacks(u8 sq, Bitboard occ) {
+    const Magic *m = &bb_bishop_magics[sq];
+    return m->attacks[((occ & m->mask) * m->magic) >> m->shift];
+}
+
+static inline u8 bb_popcount(Bitboard b) {
+    return (u8)__builtin_popcountll(b);
+}
+
+/* Index of the lowest set bit (b must be non-zero) */
+static inline u8 bb_lsb(Bitboard b) {
+    return (u8)__builtin_ctzll(b);
+}
+
+/* Remove and return the lowest set bit (b must be non-zero) */
+static inline u8 bb_pop_lsb(Bitboard *b) {
+    u8 sq = bb_lsb(*b);
+    *b &= *b - 1;
+    return sq;
+}
+
+/* Build attack and magic tables (called from tables_init) */
+void bitboard_init(void);
+
+#endif /* USE_BITBOARDS */
+
+#endif /* BITBOARD_H */
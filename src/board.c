@@ -1,13 +1,16 @@
 #include "board.h"
 #include "tables.h"
+#include "bitboard.h"
 #include <string.h>
 
 #ifndef TARGET_C64
 #include <stdio.h>
 #endif
 
-/* Global game state */
-GameState g_state;
+#ifdef COPY_MAKE
+/* Saved position blocks of the current engine */
+#define pos_stack (g_engine->pos_stack)
+#endif
 
 /* Piece characters for FEN and display */
 static const char piece_chars[] = ".PNBRQK..pnbrqk";
@@ -36,16 +39,278 @@ static s8 get_pst_value(u8 piece, u8 sq88) {
     return tbl[idx];
 }
 
+/* --- Piece list maintenance ---
+ * On PC the same helpers keep the bitboards in sync with board[]. */
+
+#ifdef USE_BITBOARDS
+static void bb_toggle(u8 color, u8 pt, Bitboard bits) {
+    g_state.bb_pieces[color][pt] ^= bits;
+    g_state.bb_color[color] ^= bits;
+    g_state.bb_occupied ^= bits;
+}
+#define BB_TOGGLE(piece, bits) \
+    bb_toggle(PIECE_COLOR(piece), PIECE_TYPE(piece), (bits))
+#else
+#define BB_TOGGLE(piece, bits)
+#endif
+
+static void plist_add(u8 piece, u8 sq) {
+    u8 color = PIECE_COLOR(piece);
+    u8 pt = PIECE_TYPE(piece);
+    u8 n = g_state.piece_count[color][pt]++;
+    g_state.piece_list[color][pt][n] = sq;
+    g_state.piece_index[sq] = n;
+    BB_TOGGLE(piece, BB_SQ(SQ_INDEX64(sq)));
+}
+
+#ifndef COPY_MAKE  /* unmake-only helpers */
+/* Drop the most recently added piece of its list (it sits on sq) */
+static void plist_pop(u8 piece, u8 sq) {
+    g_state.piece_count[PIECE_COLOR(piece)][PIECE_TYPE(piece)]--;
+    BB_TOGGLE(piece, BB_SQ(SQ_INDEX64(sq)));
+    (void)sq;
+}
+#endif
+
+/* Remove the piece on sq, filling its slot with the last list entry.
+ * Returns the vacated slot so plist_restore can undo it exactly. */
+static u8 plist_remove(u8 piece, u8 sq) {
+    u8 color = PIECE_COLOR(piece);
+    u8 pt = PIECE_TYPE(piece);
+    u8 slot = g_state.piece_index[sq];
+    u8 n = --g_state.piece_count[color][pt];
+    u8 last_sq = g_state.piece_list[color][pt][n];
+    g_state.piece_list[color][pt][slot] = last_sq;
+    g_state.piece_index[last_sq] = slot;
+    BB_TOGGLE(piece, BB_SQ(SQ_INDEX64(sq)));
+    return slot;
+}
+
+#ifndef COPY_MAKE
+/* Inverse of plist_remove: put sq back into slot, moving the entry that
+ * filled it back to the end. Keeps list order identical across make/unmake. */
+static void plist_restore(u8 piece, u8 sq, u8 slot) {
+    u8 color = PIECE_COLOR(piece);
+    u8 pt = PIECE_TYPE(piece);
+    u8 n = g_state.piece_count[color][pt]++;
+    if (slot != n) {
+        u8 moved_sq = g_state.piece_list[color][pt][slot];
+        g_state.piece_list[color][pt][n] = moved_sq;
+        g_state.piece_index[moved_sq] = n;
+    }
+    g_state.piece_list[color][pt][slot] = sq;
+    g_state.piece_index[sq] = slot;
+    BB_TOGGLE(piece, BB_SQ(SQ_INDEX64(sq)));
+}
+#endif
+
+static void plist_move(u8 piece, u8 from, u8 to) {
+    u8 slot = g_state.piece_index[from];
+    g_state.piece_list[PIECE_COLOR(piece)][PIECE_TYPE(piece)][slot] = to;
+    g_state.piece_index[to] = slot;
+    BB_TOGGLE(piece, BB_SQ(SQ_INDEX64(from)) | BB_SQ(SQ_INDEX64(to)));
+}
+
+#ifdef ATTACK_MAPS
+/* --- Incremental attack maps ---
+ * A move can only change the attacks of the pieces standing on the
+ * squares it changes, and the single rays of sliders aimed at one of
+ * those squares (discovered or newly blocked lines). make/unmake toggle
+ * those attacks off, update the board, then toggle the new ones on.
+ * Toggling is an XOR, so unmake runs exactly the same procedure. */
+
+static const u8 dir_is_diag[8] = { 1, 0, 1, 0, 0, 1, 0, 1 };
+
+typedef struct {
+    u8 changed[4];   /* squares whose occupancy the move changes */
+    u8 n_changed;
+    u8 ray_sq[32];   /* sliders aimed at a changed square ... */
+    u8 ray_dir[32];  /* ... and the king_offsets index of that ray */
+    u8 n_rays;
+} AttackUpdate;
+
+/* Flip one attacker bit; the count follows the bit */
+static void am_flip(u8 color, u8 sq, u16 bit) {
+    g_state.attackers[color][sq] ^= bit;
+    if (g_state.attackers[color][sq] & bit) {
+        g_state.attack_count[color][sq]++;
+    } else {
+        g_state.attack_count[color][sq]--;
+    }
+}
+
+/* Toggle every attack of the piece on sq against the current board */
+static void am_toggle_piece(u8 sq) {
+    u8 piece = g_state.board[sq];
+    u8 color = PIECE_COLOR(piece);
+    u8 pt = PIECE_TYPE(piece);
+    u8 i, target;
+    u16 bit;
+    s8 dir;
+
+    if (pt == KNIGHT) {
+        for (i = 0; i < 8; i++) {
+            target = (u8)(sq + knight_offsets[i]);
+            if (SQ_VALID(target)) am_flip(color, target, (u16)(0x100 << (7 - i)));
+        }
+        return;
+    }
+
+    for (i = 0; i < 8; i++) {
+        if (pt == PAWN) {
+            /* White pawns attack +15/+17 (i = 5, 7), black -17/-15 (0, 2) */
+            if (!dir_is_diag[i] || (color == WHITE) != (i > 3)) continue;
+        } else if (pt == BISHOP && !dir_is_diag[i]) {
+            continue;
+        } else if (pt == ROOK && dir_is_diag[i]) {
+            continue;
+        }
+
+        dir = king_offsets[i];
+        bit = (u16)(1 << (7 - i));   /* attacker lies in the opposite direction */
+        target = (u8)(sq + dir);
+        while (SQ_VALID(target)) {
+            am_flip(color, target, bit);
+            if (!IS_SLIDER(piece) || g_state.board[target] != EMPTY) break;
+            target = (u8)(target + dir);
+        }
+    }
+}
+
+/* Toggle the attacks of the slider on sq along direction i only */
+static void am_toggle_ray(u8 sq, u8 i) {
+    u8 color = PIECE_COLOR(g_state.board[sq]);
+    u16 bit = (u16)(1 << (7 - i));
+    s8 dir = king_offsets[i];
+    u8 target = (u8)(sq + dir);
+
+    while (SQ_VALID(target)) {
+        am_flip(color, target, bit);
+        if (g_state.board[target] != EMPTY) break;
+        target = (u8)(target + dir);
+    }
+}
+
+/* Does this ray need toggling (not already listed, slider not moving)? */
+static u8 am_ray_needed(const AttackUpdate *au, u8 sq, u8 dir) {
+    u8 i;
+    for (i = 0; i < au->n_changed; i++) {
+        if (au->changed[i] == sq) return 0;
+    }
+    for (i = 0; i < au->n_rays; i++) {
+        if (au->ray_sq[i] == sq && au->ray_dir[i] == dir) return 0;
+    }
+    return 1;
+}
+
+/* Record the squares m changes (side = the side making m), find the
+ * slider rays aimed at them, and toggle off all affected attacks */
+static void am_begin(AttackUpdate *au, Move m, u8 side) {
+    u8 i, j, c, sq, from;
+    u16 dirs;
+    u8 m_from = MOVE_FROM(m), m_to = MOVE_TO(m), m_flags = MOVE_FLAGS(m);
+
+    au->n_changed = 2;
+    au->changed[0] = m_from;
+    au->changed[1] = m_to;
+    if (m_flags & MF_EP) {
+        au->changed[au->n_changed++] = (side == WHITE) ? (u8)(m_to - 16) : (u8)(m_to + 16);
+    }
+    if (m_flags & MF_CASTLE) {
+        au->changed[au->n_changed++] = (m_to > m_from) ? (u8)(m_from + 3) : (u8)(m_from - 4);
+        au->changed[au->n_changed++] = (m_to > m_from) ? (u8)(m_from + 1) : (u8)(m_from - 1);
+    }
+
+    au->n_rays = 0;
+    for (i = 0; i < au->n_changed; i++) {
+        sq = au->changed[i];
+        for (c = 0; c < 2; c++) {
+            dirs = g_state.attackers[c][sq] & 0xFF;
+            for (j = 0; dirs; j++, dirs >>= 1) {
+                if (!(dirs & 1)) continue;
+                /* The attacker is the first piece in direction j; its
+                 * ray towards sq runs the opposite way (7 - j) */
+                from = sq;
+                do {
+                    from = (u8)(from + king_offsets[j]);
+                } while (g_state.board[from] == EMPTY);
+                if (IS_SLIDER(g_state.board[from]) &&
+                    am_ray_needed(au, from, (u8)(7 - j))) {
+                    au->ray_sq[au->n_rays] = from;
+                    au->ray_dir[au->n_rays++] = (u8)(7 - j);
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < au->n_changed; i++) {
+        if (g_state.board[au->changed[i]] != EMPTY) am_toggle_piece(au->changed[i]);
+    }
+    for (i = 0; i < au->n_rays; i++) {
+        am_toggle_ray(au->ray_sq[i], au->ray_dir[i]);
+    }
+}
+
+/* After the board update: toggle the affected pieces' new attacks on */
+static void am_end(const AttackUpdate *au) {
+    u8 i;
+    for (i = 0; i < au->n_changed; i++) {
+        if (g_state.board[au->changed[i]] != EMPTY) am_toggle_piece(au->changed[i]);
+    }
+    for (i = 0; i < au->n_rays; i++) {
+        am_toggle_ray(au->ray_sq[i], au->ray_dir[i]);
+    }
+}
+
+void board_init_attack_maps(void) {
+    u8 sq;
+    memset(g_state.attackers, 0, sizeof(g_state.attackers));
+    memset(g_state.attack_count, 0, sizeof(g_state.attack_count));
+    for (sq = 0; sq < 128; sq++) {
+        if (SQ_VALID(sq) && g_state.board[sq] != EMPTY) am_toggle_piece(sq);
+    }
+}
+#endif /* ATTACK_MAPS */
+
 void board_init(void) {
     board_set_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 }
 
+/* Does the FEN's piece placement fit the board and the piece lists? More
+ * than MAX_PIECE_SLOTS pieces of one kind would overrun their list. */
+static u8 fen_placement_ok(const char *p) {
+    u8 count[2][7];
+    u8 file = 0, piece;
+
+    memset(count, 0, sizeof(count));
+    for (; *p && *p != ' '; p++) {
+        if (*p == '/') {
+            file = 0;
+        } else if (*p >= '1' && *p <= '8') {
+            file += (u8)(*p - '0');
+        } else {
+            piece = char_to_piece(*p);
+            if (piece != EMPTY) {
+                if (file > 7) return 0;
+                if (++count[PIECE_COLOR(piece)][PIECE_TYPE(piece)] > MAX_PIECE_SLOTS) {
+                    return 0;
+                }
+            }
+            file++;
+        }
+    }
+    return 1;
+}
+
 u8 board_set_fen(const char *fen) {
     u8 rank, file, sq;
     u8 piece;
     u8 color;
     const char *p = fen;
 
+    /* Reject before touching g_state, so the old position stays */
+    if (!fen_placement_ok(fen)) return 0;
+
     memset(&g_state, 0, sizeof(GameState));
     g_state.ep_square = SQ_NONE;
 
@@ -64,6 +329,7 @@ u8 board_set_fen(const char *fen) {
             if (piece != EMPTY) {
                 sq = SQ_MAKE(rank, file);
                 g_state.board[sq] = piece;
+                plist_add(piece, sq);
                 color = PIECE_COLOR(piece);
 
                 /* Update material and PST scores */
@@ -137,10 +403,17 @@ u8 board_set_fen(const char *fen) {
         g_state.ply = (fullmove - 1) * 2 + g_state.side;
     }
 
-    /* Compute Zobrist hash */
+#ifdef ATTACK_MAPS
+    board_init_attack_maps();
+#endif
+
+    /* Compute Zobrist hash and the pawn/material keys */
     g_state.hash = board_compute_hash();
+    g_state.pawn_hash = board_compute_pawn_hash();
+    g_state.material_hash = board_compute_material_hash();
     g_state.undo_ply = 0;
     g_state.hash_hist_count = 0;
+    g_state.plies_from_null = 0;
 
     return 1;
 }
@@ -225,132 +498,45 @@ void board_get_fen(char *buf) {
     *p = '\0';
 }
 
-u8 board_make_move(Move m) {
-    u8 from = m.from;
-    u8 to = m.to;
-    u8 flags = m.flags;
-    u8 piece = g_state.board[from];
-    u8 captured = g_state.board[to];
-    u8 side = g_state.side;
-    u8 opp = side ^ 1;
-    u8 pt = PIECE_TYPE(piece);
-    Undo *undo;
-
-    /* Save undo info */
-    undo = &g_state.undo_stack[g_state.undo_ply];
-    undo->captured = captured;
-    undo->castle_rights = g_state.castle_rights;
-    undo->ep_square = g_state.ep_square;
-    undo->fifty_clock = g_state.fifty_clock;
-    undo->hash = g_state.hash;
-    undo->material[0] = g_state.material[0];
-    undo->material[1] = g_state.material[1];
-    undo->pst_score[0] = g_state.pst_score[0];
-    undo->pst_score[1] = g_state.pst_score[1];
-
-    /* Save hash for repetition detection */
-    g_state.hash_history[g_state.hash_hist_count++] = g_state.hash;
-
-    /* Update fifty-move clock */
-    g_state.fifty_clock++;
-    if (pt == PAWN || captured != EMPTY) {
-        g_state.fifty_clock = 0;
-    }
-
-    /* Remove piece from source */
-    g_state.hash ^= zobrist_pieces[side][pt][from];
-    g_state.pst_score[side] -= get_pst_value(piece, from);
-    g_state.board[from] = EMPTY;
-
-    /* Handle capture */
-    if (captured != EMPTY) {
-        u8 cap_type = PIECE_TYPE(captured);
-        g_state.hash ^= zobrist_pieces[opp][cap_type][to];
-        g_state.material[opp] -= material_value[cap_type];
-        g_state.pst_score[opp] -= get_pst_value(captured, to);
-    }
-
-    /* Handle en passant capture */
-    if (flags & MF_EP) {
-        u8 ep_cap_sq = (side == WHITE) ? (u8)(to - 16) : (u8)(to + 16);
-        u8 ep_piece = g_state.board[ep_cap_sq];
-        if (ep_piece != EMPTY) {
-            u8 ep_type = PIECE_TYPE(ep_piece);
-            g_state.hash ^= zobrist_pieces[opp][ep_type][ep_cap_sq];
-            g_state.material[opp] -= material_value[ep_type];
-            g_state.pst_score[opp] -= get_pst_value(ep_piece, ep_cap_sq);
-            g_state.board[ep_cap_sq] = EMPTY;
-            undo->captured = ep_piece;
-        }
+#if !defined(ATTACK_MAPS) && !defined(USE_BITBOARDS)
+/* Is every square strictly between 'from' and 'to' empty?
+ * The squares must share a line (delta_table entry non-zero). */
+static u8 ray_clear(u8 from, u8 to) {
+    s8 step = delta_table[ATTACK_INDEX(from, to)];
+    u8 sq = (u8)(to + step);
+    while (sq != from) {
+        if (g_state.board[sq] != EMPTY) return 0;
+        sq = (u8)(sq + step);
     }
+    return 1;
+}
+#endif
 
-    /* Handle promotion */
-    if (flags & MF_PROMO) {
-        u8 promo_type = PROMO_TYPE(flags);
-        u8 promo_piece = MAKE_PIECE(side, promo_type);
-        g_state.board[to] = promo_piece;
-        g_state.hash ^= zobrist_pieces[side][promo_type][to];
-        g_state.pst_score[side] += get_pst_value(promo_piece, to);
-        /* Adjust material: remove pawn value, add promotion piece value */
-        g_state.material[side] -= material_value[PAWN];
-        g_state.material[side] += material_value[promo_type];
+/* Color-specialized make_move_white/_black, unmake_move_white/_black and
+ * (0x88 attacks) is_attacked_by_white/_black */
+#define SIDE WHITE
+#include "board_side.h"
+#undef SIDE
+#define SIDE BLACK
+#include "board_side.h"
+#undef SIDE
+
+/* Apply m; legality is the caller's business */
+static void make_move(Move m) {
+    if (g_state.side == WHITE) {
+        make_move_white(m);
     } else {
-        /* Normal move: place piece at destination */
-        g_state.board[to] = piece;
-        g_state.hash ^= zobrist_pieces[side][pt][to];
-        g_state.pst_score[side] += get_pst_value(piece, to);
-    }
-
-    /* Update king position */
-    if (pt == KING) {
-        g_state.king_sq[side] = to;
-    }
-
-    /* Handle castling move (move the rook) */
-    if (flags & MF_CASTLE) {
-        u8 rook_from, rook_to;
-        u8 rook_piece = MAKE_PIECE(side, ROOK);
-        if (to > from) {
-            /* Kingside */
-            rook_from = (u8)(from + 3);
-            rook_to = (u8)(from + 1);
-        } else {
-            /* Queenside */
-            rook_from = (u8)(from - 4);
-            rook_to = (u8)(from - 1);
-        }
-        g_state.board[rook_from] = EMPTY;
-        g_state.board[rook_to] = rook_piece;
-        g_state.hash ^= zobrist_pieces[side][ROOK][rook_from];
-        g_state.hash ^= zobrist_pieces[side][ROOK][rook_to];
-        g_state.pst_score[side] -= get_pst_value(rook_piece, rook_from);
-        g_state.pst_score[side] += get_pst_value(rook_piece, rook_to);
+        make_move_black(m);
     }
+}
 
-    /* Update castling rights */
-    g_state.hash ^= zobrist_castle[g_state.castle_rights];
-    g_state.castle_rights &= castle_mask[from] & castle_mask[to];
-    g_state.hash ^= zobrist_castle[g_state.castle_rights];
-
-    /* Update en passant square */
-    if (g_state.ep_square != SQ_NONE) {
-        g_state.hash ^= zobrist_ep[SQ_FILE(g_state.ep_square)];
-    }
-    if ((flags & MF_PAWNSTART) && pt == PAWN) {
-        g_state.ep_square = (side == WHITE) ? (u8)(from + 16) : (u8)(from - 16);
-        g_state.hash ^= zobrist_ep[SQ_FILE(g_state.ep_square)];
-    } else {
-        g_state.ep_square = SQ_NONE;
-    }
+u8 board_make_move(Move m) {
+    u8 side = g_state.side;
 
-    /* Switch side */
-    g_state.side ^= 1;
-    g_state.hash ^= zobrist_side;
-    g_state.ply++;
-    g_state.undo_ply++;
+    make_move(m);
 
     /* Verify legality: king must not be in check */
-    if (board_is_square_attacked(g_state.king_sq[side], opp)) {
+    if (board_is_square_attacked(g_state.king_sq[side], side ^ 1)) {
         board_unmake_move(m);
         return 0; /* illegal move */
     }
@@ -358,71 +544,29 @@ u8 board_make_move(Move m) {
     return 1; /* legal */
 }
 
+void board_make_legal_move(Move m) {
+    make_move(m);
+}
+
+#ifdef COPY_MAKE
 void board_unmake_move(Move m) {
-    u8 from = m.from;
-    u8 to = m.to;
-    u8 flags = m.flags;
-    u8 side, pt;
-    Undo *undo;
+    (void)m;
 
-    /* Switch back */
-    g_state.side ^= 1;
-    g_state.ply--;
+    /* Side, ply, hash and board all come back with the position block */
     g_state.undo_ply--;
     g_state.hash_hist_count--;
-
-    side = g_state.side;
-    undo = &g_state.undo_stack[g_state.undo_ply];
-
-    /* Restore state */
-    g_state.castle_rights = undo->castle_rights;
-    g_state.ep_square = undo->ep_square;
-    g_state.fifty_clock = undo->fifty_clock;
-    g_state.hash = undo->hash;
-    g_state.material[0] = undo->material[0];
-    g_state.material[1] = undo->material[1];
-    g_state.pst_score[0] = undo->pst_score[0];
-    g_state.pst_score[1] = undo->pst_score[1];
-
-    /* Handle promotion: piece on 'to' is promoted piece, restore pawn */
-    if (flags & MF_PROMO) {
-        g_state.board[from] = MAKE_PIECE(side, PAWN);
-    } else {
-        g_state.board[from] = g_state.board[to];
-    }
-
-    pt = PIECE_TYPE(g_state.board[from]);
-
-    /* Update king position */
-    if (pt == KING) {
-        g_state.king_sq[side] = from;
-    }
-
-    /* Handle en passant: restore captured pawn to correct square */
-    if (flags & MF_EP) {
-        u8 ep_cap_sq = (side == WHITE) ? (u8)(to - 16) : (u8)(to + 16);
-        g_state.board[to] = EMPTY;
-        g_state.board[ep_cap_sq] = undo->captured;
+    memcpy(&g_state, pos_stack[g_state.undo_ply], POSITION_BYTES);
+}
+#else
+void board_unmake_move(Move m) {
+    /* m was made by the side not to move now */
+    if (g_state.side == BLACK) {
+        unmake_move_white(m);
     } else {
-        /* Restore captured piece (or EMPTY) to target square */
-        g_state.board[to] = undo->captured;
-    }
-
-    /* Handle castling: move rook back */
-    if (flags & MF_CASTLE) {
-        u8 rook_from, rook_to;
-        u8 rook_piece = MAKE_PIECE(side, ROOK);
-        if (to > from) {
-            rook_from = (u8)(from + 3);
-            rook_to = (u8)(from + 1);
-        } else {
-            rook_from = (u8)(from - 4);
-            rook_to = (u8)(from - 1);
-        }
-        g_state.board[rook_to] = EMPTY;
-        g_state.board[rook_from] = rook_piece;
+        unmake_move_black(m);
     }
 }
+#endif /* COPY_MAKE */
 
 void board_make_null(void) {
     Undo *undo = &g_state.undo_stack[g_state.undo_ply];
@@ -431,6 +575,7 @@ void board_make_null(void) {
     undo->castle_rights = g_state.castle_rights;
     undo->ep_square = g_state.ep_square;
     undo->fifty_clock = g_state.fifty_clock;
+    undo->plies_from_null = g_state.plies_from_null;
     undo->hash = g_state.hash;
     undo->material[0] = g_state.material[0];
     undo->material[1] = g_state.material[1];
@@ -439,6 +584,12 @@ void board_make_null(void) {
 
     g_state.hash_history[g_state.hash_hist_count++] = g_state.hash;
 
+    /* Positions before a pass are not reachable in a legal game, so the
+     * repetition scans stop here */
+    g_state.plies_from_null = 0;
+
+    /* Pawns and material are untouched, so pawn_hash and material_hash
+     * need neither an update nor an Undo copy */
     if (g_state.ep_square != SQ_NONE) {
         g_state.hash ^= zobrist_ep[SQ_FILE(g_state.ep_square)];
         g_state.ep_square = SQ_NONE;
@@ -461,6 +612,7 @@ void board_unmake_null(void) {
         g_state.castle_rights = undo->castle_rights;
         g_state.ep_square = undo->ep_square;
         g_state.fifty_clock = undo->fifty_clock;
+        g_state.plies_from_null = undo->plies_from_null;
         g_state.hash = undo->hash;
         g_state.material[0] = undo->material[0];
         g_state.material[1] = undo->material[1];
@@ -469,105 +621,205 @@ void board_unmake_null(void) {
     }
 }
 
-u8 board_is_square_attacked(u8 sq, u8 by_side) {
-    u8 i, target_sq, piece, pt;
+/* Is every square strictly between a and b (on one line) empty, treating
+ * 'vacated' as empty too? */
+static u8 line_clear(u8 a, u8 b, u8 vacated) {
+    s8 step = delta_table[ATTACK_INDEX(b, a)];
+    u8 sq;
+    for (sq = (u8)(a + step); sq != b; sq = (u8)(sq + step)) {
+        if (g_state.board[sq] != EMPTY && sq != vacated) return 0;
+    }
+    return 1;
+}
+
+u8 board_gives_check(Move m) {
+    u8 side = g_state.side;
+    u8 ksq = g_state.king_sq[side ^ 1];
+    u8 from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+    u8 pt = PIECE_TYPE(g_state.board[from]);
+    u8 atk, sq, piece;
     s8 dir;
-    u8 opp_color = by_side ? COLOR_MASK : 0;
 
-    /* Check knight attacks */
-    for (i = 0; i < 8; i++) {
-        target_sq = (u8)((s8)sq + knight_offsets[i]);
-        if (SQ_VALID(target_sq)) {
-            piece = g_state.board[target_sq];
-            if (piece != EMPTY && PIECE_TYPE(piece) == KNIGHT &&
-                (piece & COLOR_MASK) == opp_color) {
-                return 1;
-            }
+    /* Castling and en passant move two pieces: play them out */
+    if (flags & (MF_CASTLE | MF_EP)) {
+        u8 check = 0;
+        if (board_make_move(m)) {
+            check = board_in_check();
+            board_unmake_move(m);
         }
+        return check;
+    }
+
+    /* Direct check by the piece as it stands on 'to' */
+    if (flags & MF_PROMO) pt = PROMO_TYPE(flags);
+    atk = attack_table[ATTACK_INDEX(to, ksq)];
+    switch (pt) {
+        case PAWN:   atk &= (side == WHITE) ? ATK_WPAWN : ATK_BPAWN; break;
+        case KNIGHT: atk &= ATK_KNIGHT; break;
+        case BISHOP: atk &= ATK_BISHOP; break;
+        case ROOK:   atk &= ATK_ROOK; break;
+        case QUEEN:  atk &= ATK_QUEEN; break;
+        default:     atk = 0; break;
+    }
+    if (atk) {
+        if (pt == PAWN || pt == KNIGHT) return 1;
+        if (line_clear(ksq, to, from)) return 1;
+    }
+
+    /* Discovered check: 'from' was the only piece between the king and
+     * one of our sliders, and 'to' leaves that line */
+    dir = delta_table[ATTACK_INDEX(from, ksq)];
+    if (dir == 0 || delta_table[ATTACK_INDEX(to, ksq)] == dir) return 0;
+    if (!line_clear(ksq, from, SQ_NONE)) return 0;
+    for (sq = (u8)(from + dir); SQ_VALID(sq); sq = (u8)(sq + dir)) {
+        piece = g_state.board[sq];
+        if (piece == EMPTY) continue;
+        if (PIECE_COLOR(piece) != side) return 0;
+        pt = PIECE_TYPE(piece);
+        return pt == QUEEN ||
+               pt == ((dir == 1 || dir == -1 || dir == 16 || dir == -16) ? ROOK : BISHOP);
     }
+    return 0;
+}
 
-    /* Check pawn attacks */
-    if (by_side == WHITE) {
-        /* White pawns attack diagonally upward from their position */
-        target_sq = (u8)((s8)sq - 15); /* down-right from target = pawn is SW */
-        if (SQ_VALID(target_sq) && g_state.board[target_sq] == W_PAWN) return 1;
-        target_sq = (u8)((s8)sq - 17); /* down-left from target = pawn is SE */
-        if (SQ_VALID(target_sq) && g_state.board[target_sq] == W_PAWN) return 1;
+/* Castling from 'from' to 'to' as movegen would generate it: the right is
+ * held, the squares between king and rook are empty, and the king does
+ * not start in, pass through, or land on an attacked square */
+static u8 castle_is_pseudo_legal(u8 from, u8 to) {
+    u8 side = g_state.side;
+    u8 opp = side ^ 1;
+    u8 home = (side == WHITE) ? SQ_E1 : SQ_E8;
+    u8 right;
+    s8 step;
+
+    if (from != home) return 0;
+    if (to == (u8)(home + 2)) {
+        right = (side == WHITE) ? CASTLE_WK : CASTLE_BK;
+        step = 1;
+    } else if (to == (u8)(home - 2)) {
+        right = (side == WHITE) ? CASTLE_WQ : CASTLE_BQ;
+        step = -1;
+        if (g_state.board[(u8)(home - 3)] != EMPTY) return 0;
     } else {
-        /* Black pawns attack diagonally downward */
-        target_sq = (u8)((s8)sq + 15); /* up-left from target = pawn is NE */
-        if (SQ_VALID(target_sq) && g_state.board[target_sq] == B_PAWN) return 1;
-        target_sq = (u8)((s8)sq + 17); /* up-right from target = pawn is NW */
-        if (SQ_VALID(target_sq) && g_state.board[target_sq] == B_PAWN) return 1;
+        return 0;
     }
 
-    /* Check king attacks (adjacent squares) */
-    {
-        static const s8 king_dirs[8] = { -17, -16, -15, -1, 1, 15, 16, 17 };
-        for (i = 0; i < 8; i++) {
-            target_sq = (u8)((s8)sq + king_dirs[i]);
-            if (SQ_VALID(target_sq)) {
-                piece = g_state.board[target_sq];
-                if (piece != EMPTY && PIECE_TYPE(piece) == KING &&
-                    (piece & COLOR_MASK) == opp_color) {
-                    return 1;
-                }
-            }
-        }
+    if (!(g_state.castle_rights & right)) return 0;
+    if (g_state.board[(u8)(home + step)] != EMPTY ||
+        g_state.board[to] != EMPTY) {
+        return 0;
     }
+    return !board_is_square_attacked(home, opp) &&
+           !board_is_square_attacked((u8)(home + step), opp) &&
+           !board_is_square_attacked(to, opp);
+}
 
-    /* Check sliding piece attacks: bishop/queen on diagonals */
-    for (i = 0; i < 4; i++) {
-        dir = bishop_offsets[i];
-        target_sq = (u8)((s8)sq + dir);
-        while (SQ_VALID(target_sq)) {
-            piece = g_state.board[target_sq];
-            if (piece != EMPTY) {
-                if ((piece & COLOR_MASK) == opp_color) {
-                    pt = PIECE_TYPE(piece);
-                    if (pt == BISHOP || pt == QUEEN) return 1;
-                }
-                break;
-            }
-            target_sq = (u8)((s8)target_sq + dir);
+u8 board_is_pseudo_legal(Move m) {
+    u8 side = g_state.side;
+    u8 from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+    u8 piece, target, pt, atk, fwd;
+    s8 forward;
+
+    if (from == to || (flags & MF_INVALID)) return 0;
+    piece = g_state.board[from];
+    if (piece == EMPTY || PIECE_COLOR(piece) != side) return 0;
+    target = g_state.board[to];
+    if (target != EMPTY && PIECE_COLOR(target) == side) return 0;
+    pt = PIECE_TYPE(piece);
+
+    if (flags & MF_CASTLE) {
+        return flags == MF_CASTLE && pt == KING &&
+               castle_is_pseudo_legal(from, to);
+    }
+    if (pt != PAWN) {
+        if (flags & (MF_EP | MF_PAWNSTART | MF_PROMO)) return 0;
+        if (((flags & MF_CAPTURE) != 0) != (target != EMPTY)) return 0;
+        atk = attack_table[ATTACK_INDEX(to, from)];
+        switch (pt) {
+            case KNIGHT: return (atk & ATK_KNIGHT) != 0;
+            case KING:   return (atk & ATK_KING) != 0;
+            case BISHOP: atk &= ATK_BISHOP; break;
+            case ROOK:   atk &= ATK_ROOK; break;
+            default:     atk &= ATK_QUEEN; break;
         }
+        return atk && line_clear(from, to, SQ_NONE);
     }
 
-    /* Check sliding piece attacks: rook/queen on ranks/files */
-    for (i = 0; i < 4; i++) {
-        dir = rook_offsets[i];
-        target_sq = (u8)((s8)sq + dir);
-        while (SQ_VALID(target_sq)) {
-            piece = g_state.board[target_sq];
-            if (piece != EMPTY) {
-                if ((piece & COLOR_MASK) == opp_color) {
-                    pt = PIECE_TYPE(piece);
-                    if (pt == ROOK || pt == QUEEN) return 1;
-                }
-                break;
-            }
-            target_sq = (u8)((s8)target_sq + dir);
+    /* Pawns: promotion flag iff the last rank is reached */
+    forward = (side == WHITE) ? 16 : -16;
+    fwd = (u8)(from + forward);
+    if (((flags & MF_PROMO) != 0) != (SQ_RANK(to) == ((side == WHITE) ? 7 : 0))) {
+        return 0;
+    }
+
+    if (to == (u8)(fwd - 1) || to == (u8)(fwd + 1)) {
+        if (flags & MF_EP) {
+            return flags == (MF_CAPTURE | MF_EP) &&
+                   to == g_state.ep_square && target == EMPTY;
         }
+        return (flags & MF_CAPTURE) && !(flags & MF_PAWNSTART) &&
+               target != EMPTY;
+    }
+    if (flags & (MF_CAPTURE | MF_EP) || target != EMPTY) return 0;
+    if (to == fwd) return !(flags & MF_PAWNSTART);
+    if (to == (u8)(fwd + forward)) {
+        return flags == MF_PAWNSTART &&
+               SQ_RANK(from) == ((side == WHITE) ? 1 : 6) &&
+               g_state.board[fwd] == EMPTY;
     }
+    return 0;
+}
 
+#if defined(ATTACK_MAPS)
+u8 board_is_square_attacked(u8 sq, u8 by_side) {
+    return g_state.attack_count[by_side][sq] != 0;
+}
+#elif defined(USE_BITBOARDS)
+u8 board_is_square_attacked(u8 sq, u8 by_side) {
+    u8 s = SQ_INDEX64(sq);
+    const Bitboard *bb = g_state.bb_pieces[by_side];
+    Bitboard occ = g_state.bb_occupied;
+
+    /* Attacked by a pawn of by_side iff a pawn of the other color on sq
+     * would attack that pawn */
+    if (bb_pawn_attacks[by_side ^ 1][s] & bb[PAWN]) return 1;
+    if (bb_knight_attacks[s] & bb[KNIGHT]) return 1;
+    if (bb_king_attacks[s] & bb[KING]) return 1;
+    if (bb_bishop_attacks(s, occ) & (bb[BISHOP] | bb[QUEEN])) return 1;
+    if (bb_rook_attacks(s, occ) & (bb[ROOK] | bb[QUEEN])) return 1;
     return 0;
 }
+#else
+u8 board_is_square_attacked(u8 sq, u8 by_side) {
+    return (by_side == WHITE) ? is_attacked_by_white(sq) : is_attacked_by_black(sq);
+}
+#endif /* ATTACK_MAPS / USE_BITBOARDS */
 
 u8 board_in_check(void) {
     return board_is_square_attacked(g_state.king_sq[g_state.side],
                                      g_state.side ^ 1);
 }
 
+/* Number of plies back the repetition scans may look: positions before
+ * the last capture or pawn move (fifty_clock) cannot recur, and those
+ * before a null move are not part of a legal line */
+static u16 repetition_window(void) {
+    u16 end = g_state.fifty_clock;
+    if (end > g_state.plies_from_null) end = g_state.plies_from_null;
+    if (end > g_state.hash_hist_count) end = g_state.hash_hist_count;
+    return end;
+}
+
 u8 board_is_repetition(void) {
-    u16 i;
+    u16 d, end, n = g_state.hash_hist_count;
     u8 count = 0;
     HashKey current_hash = g_state.hash;
 
-    /* Only check back to last irreversible move (fifty_clock positions) */
-    if (g_state.hash_hist_count < 4) return 0;
-
-    for (i = g_state.hash_hist_count; i > 0; i--) {
-        if (g_state.hash_history[i - 1] == current_hash) {
+    /* Same side to move only (even distances), and a position cannot
+     * repeat in fewer than 4 plies */
+    end = repetition_window();
+    for (d = 4; d <= end; d += 2) {
+        if (g_state.hash_history[n - d] == current_hash) {
             count++;
             if (count >= 2) return 1; /* third occurrence including current */
         }
@@ -575,6 +827,65 @@ u8 board_is_repetition(void) {
     return 0;
 }
 
+u8 board_is_repetition_draw(u8 ply) {
+    u16 d, end, n = g_state.hash_hist_count;
+    u8 count = 0;
+    HashKey current_hash = g_state.hash;
+
+    end = repetition_window();
+    for (d = 4; d <= end; d += 2) {
+        if (g_state.hash_history[n - d] == current_hash) {
+            /* Repeating a position from inside the search tree: the side
+             * that allowed it can repeat again, so score it a draw now */
+            if (d < ply) return 1;
+            count++;
+            if (count >= 2) return 1;
+        }
+    }
+    return 0;
+}
+
+#ifndef TARGET_C64
+u8 board_has_game_cycle(u8 ply) {
+    u16 d, end, n = g_state.hash_hist_count;
+    u16 slot;
+    u8 sq1, sq2, sq;
+    s8 step;
+    HashKey move_key;
+
+    end = repetition_window();
+    if (end < 3) return 0;
+
+    /* A position d plies back (d odd, so the opponent was to move there)
+     * is one reversible move away if the key difference is a cuckoo entry */
+    for (d = 3; d <= end; d += 2) {
+        move_key = g_state.hash ^ g_state.hash_history[n - d];
+
+        slot = CUCKOO_H1(move_key);
+        if (cuckoo_keys[slot] != move_key) {
+            slot = CUCKOO_H2(move_key);
+            if (cuckoo_keys[slot] != move_key) continue;
+        }
+
+        /* The squares between must be empty (knights have no ray) */
+        sq1 = cuckoo_sq1[slot];
+        sq2 = cuckoo_sq2[slot];
+        step = delta_table[ATTACK_INDEX(sq1, sq2)];
+        if (step != 0) {
+            for (sq = (u8)(sq2 + step); sq != sq1; sq = (u8)(sq + step)) {
+                if (g_state.board[sq] != EMPTY) break;
+            }
+            if (sq != sq1) continue;
+        }
+
+        /* Only cycles closing inside the search tree count; older ones
+         * would need a threefold and are left to board_is_repetition_draw */
+        if (d < ply) return 1;
+    }
+    return 0;
+}
+#endif
+
 HashKey board_compute_hash(void) {
     HashKey hash = 0;
     u8 sq, piece, color, pt;
@@ -599,6 +910,46 @@ HashKey board_compute_hash(void) {
     return hash;
 }
 
+HashKey board_compute_pawn_hash(void) {
+    HashKey hash = 0;
+    u8 sq, piece;
+
+    for (sq = 0; sq < 128; sq++) {
+        if (!SQ_VALID(sq)) continue;
+        piece = g_state.board[sq];
+        if (PIECE_TYPE(piece) != PAWN) continue;
+        hash ^= zobrist_pieces[PIECE_COLOR(piece)][PAWN][sq];
+    }
+
+    return hash;
+}
+
+HashKey board_compute_material_hash(void) {
+    HashKey hash = 0;
+    u8 count[2][7];
+    u8 sq, piece, color, pt, n;
+
+    /* Count from the board rather than piece_count so tests catch list
+     * drift as well */
+    memset(count, 0, sizeof(count));
+    for (sq = 0; sq < 128; sq++) {
+        if (!SQ_VALID(sq)) continue;
+        piece = g_state.board[sq];
+        if (piece == EMPTY) continue;
+        count[PIECE_COLOR(piece)][PIECE_TYPE(piece)]++;
+    }
+
+    for (color = 0; color < 2; color++) {
+        for (pt = PAWN; pt <= KING; pt++) {
+            for (n = 0; n < count[color][pt]; n++) {
+                hash ^= zobrist_pieces[color][pt][n];
+            }
+        }
+    }
+
+    return hash;
+}
+
 char file_to_char(u8 file) { return (char)('a' + file); }
 char rank_to_char(u8 rank) { return (char)('1' + rank); }
 
@@ -642,6 +993,6 @@ void board_print(void) {
         printf("%c%c", file_to_char(SQ_FILE(g_state.ep_square)),
                        rank_to_char(SQ_RANK(g_state.ep_square)));
     }
-    printf("  Hash: %08lX\n\n", (unsigned long)g_state.hash);
+    printf("  Hash: %016llX\n\n", (unsigned long long)g_state.hash);
 }
 #endif
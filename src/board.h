@@ -6,7 +6,9 @@
 /* Initialize board to starting position */
 void board_init(void);
 
-/* Set board from FEN string. Returns 1 on success, 0 on failure. */
+/* Set board from FEN string. Returns 1 on success, 0 on failure: a FEN
+ * with a piece off the board or more than MAX_PIECE_SLOTS pieces of one
+ * kind is rejected and leaves the position unchanged. */
 u8 board_set_fen(const char *fen);
 
 /* Convert board to FEN string (writes to buf, must be >= 90 bytes) */
@@ -15,6 +17,10 @@ void board_get_fen(char *buf);
 /* Make a move on the board. Returns 1 if legal (king not in check after). */
 u8 board_make_move(Move m);
 
+/* Make a move already known to be legal (from the movegen _legal
+ * generators), skipping the king-safety test */
+void board_make_legal_move(Move m);
+
 /* Unmake the last move */
 void board_unmake_move(Move m);
 
@@ -25,15 +31,50 @@ void board_unmake_null(void);
 /* Check if a square is attacked by the given side */
 u8 board_is_square_attacked(u8 sq, u8 by_side);
 
+#ifdef ATTACK_MAPS
+/* Rebuild the attack maps from scratch (done by board_set_fen; exposed
+ * so tests can compare against the incrementally updated maps) */
+void board_init_attack_maps(void);
+#endif
+
+/* Does m (pseudo-legal for the side to move) check the enemy king?
+ * Direct and discovered checks are read from 0x88 geometry without
+ * making the move; castling and en passant are made and tested. */
+u8 board_gives_check(Move m);
+
+/* Could m (e.g. a TT move or killer from another position) have been
+ * generated here? Checks piece ownership, flags against the board, pawn
+ * pushes, en passant, slider paths, and castling rights, emptiness and
+ * attacked squares. Does not test whether the king is left in check. */
+u8 board_is_pseudo_legal(Move m);
+
 /* Check if current side's king is in check */
 u8 board_in_check(void);
 
 /* Check for repetition (threefold) */
 u8 board_is_repetition(void);
 
+/* Repetition draw as scored by the search, ply plies from the root: any
+ * repeat of a position reached after the root, or a threefold */
+u8 board_is_repetition_draw(u8 ply);
+
+#ifndef TARGET_C64
+/* Upcoming repetition: can the side to move play a reversible move that
+ * recreates a position seen after the root? Uses the cuckoo table. */
+u8 board_has_game_cycle(u8 ply);
+#endif
+
 /* Compute Zobrist hash from scratch (for verification) */
 HashKey board_compute_hash(void);
 
+/* Compute the pawn-only key from scratch (for verification) */
+HashKey board_compute_pawn_hash(void);
+
+/* Compute the material signature from scratch (for verification): the
+ * n-th piece of a [color][type] contributes zobrist_pieces[color][type][n],
+ * so equal piece counts always give equal keys */
+HashKey board_compute_material_hash(void);
+
 /* Print board to stdout (for debugging on PC) */
 void board_print(void);
 
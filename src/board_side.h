@@ -0,0 +1,338 @@
+/*
+ * Color template for board.c - included once with SIDE defined as WHITE
+ * and once as BLACK (no include guard). Each pass instantiates
+ * make_move_<color>, unmake_move_<color> and, on the 0x88 attack backend,
+ * is_attacked_by_<color>, so the pawn direction, ep square, piece codes
+ * and PST orientation are compile-time constants instead of branches on
+ * the side to move. board.c dispatches on the color once per call.
+ *
+ * Expects the piece-list, attack-map and PST helpers of board.c (and
+ * ray_clear for the 0x88 backend) to be defined before inclusion.
+ */
+
+#if SIDE == WHITE
+#define US            WHITE
+#define THEM          BLACK
+#define PAWN_UP       16
+#define US_SQ64(sq)   SQ_INDEX64(sq)
+#define THEM_SQ64(sq) SQ_INDEX64(SQ_FLIP(sq))
+#define SIDE_FN(name) name##_white
+#else
+#define US            BLACK
+#define THEM          WHITE
+#define PAWN_UP       (-16)
+#define US_SQ64(sq)   SQ_INDEX64(SQ_FLIP(sq))
+#define THEM_SQ64(sq) SQ_INDEX64(sq)
+#define SIDE_FN(name) name##_black
+#endif
+
+/* Piece-square value of a piece of type pt of either color on sq */
+#define US_PST(pt, sq)   (pst_table[pt][US_SQ64(sq)])
+#define THEM_PST(pt, sq) (pst_table[pt][THEM_SQ64(sq)])
+
+/* Apply m for US; legality is the caller's business */
+static void SIDE_FN(make_move)(Move m) {
+    u8 from = MOVE_FROM(m);
+    u8 to = MOVE_TO(m);
+    u8 flags = MOVE_FLAGS(m);
+    u8 piece = g_state.board[from];
+    u8 captured = g_state.board[to];
+    u8 pt = PIECE_TYPE(piece);
+    Undo *undo;
+#ifdef ATTACK_MAPS
+    AttackUpdate au;
+#endif
+
+    undo = &g_state.undo_stack[g_state.undo_ply];
+#ifdef COPY_MAKE
+    /* Save the whole position; unmake copies it back */
+    memcpy(pos_stack[g_state.undo_ply], &g_state, POSITION_BYTES);
+#else
+    /* Save undo info */
+    undo->captured = captured;
+    undo->castle_rights = g_state.castle_rights;
+    undo->ep_square = g_state.ep_square;
+    undo->fifty_clock = g_state.fifty_clock;
+    undo->plies_from_null = g_state.plies_from_null;
+    undo->hash = g_state.hash;
+    undo->pawn_hash = g_state.pawn_hash;
+    undo->material_hash = g_state.material_hash;
+    undo->material[0] = g_state.material[0];
+    undo->material[1] = g_state.material[1];
+    undo->pst_score[0] = g_state.pst_score[0];
+    undo->pst_score[1] = g_state.pst_score[1];
+#endif
+
+    /* Save hash for repetition detection */
+    g_state.hash_history[g_state.hash_hist_count++] = g_state.hash;
+
+    /* Update fifty-move clock */
+    g_state.fifty_clock++;
+    if (pt == PAWN || captured != EMPTY) {
+        g_state.fifty_clock = 0;
+    }
+    if (g_state.plies_from_null != 0xFF) g_state.plies_from_null++;
+
+#ifdef ATTACK_MAPS
+    am_begin(&au, m, US);
+#endif
+
+    /* Remove piece from source */
+    g_state.hash ^= zobrist_pieces[US][pt][from];
+    g_state.pst_score[US] -= US_PST(pt, from);
+    g_state.board[from] = EMPTY;
+
+    /* Handle capture */
+    if (captured != EMPTY) {
+        u8 cap_type = PIECE_TYPE(captured);
+        undo->cap_slot = plist_remove(captured, to);
+        g_state.hash ^= zobrist_pieces[THEM][cap_type][to];
+        g_state.material_hash ^=
+            zobrist_pieces[THEM][cap_type][g_state.piece_count[THEM][cap_type]];
+        if (cap_type == PAWN) {
+            g_state.pawn_hash ^= zobrist_pieces[THEM][PAWN][to];
+        }
+        g_state.material[THEM] -= material_value[cap_type];
+        g_state.pst_score[THEM] -= THEM_PST(cap_type, to);
+    }
+
+    /* Handle en passant capture */
+    if (flags & MF_EP) {
+        u8 ep_cap_sq = (u8)(to - PAWN_UP);
+        u8 ep_piece = g_state.board[ep_cap_sq];
+        if (ep_piece != EMPTY) {
+            undo->cap_slot = plist_remove(ep_piece, ep_cap_sq);
+            g_state.hash ^= zobrist_pieces[THEM][PAWN][ep_cap_sq];
+            g_state.pawn_hash ^= zobrist_pieces[THEM][PAWN][ep_cap_sq];
+            g_state.material_hash ^=
+                zobrist_pieces[THEM][PAWN][g_state.piece_count[THEM][PAWN]];
+            g_state.material[THEM] -= material_value[PAWN];
+            g_state.pst_score[THEM] -= THEM_PST(PAWN, ep_cap_sq);
+            g_state.board[ep_cap_sq] = EMPTY;
+            undo->captured = ep_piece;
+        }
+    }
+
+    /* Handle promotion */
+    if (flags & MF_PROMO) {
+        u8 promo_type = PROMO_TYPE(flags);
+        u8 promo_piece = MAKE_PIECE(US, promo_type);
+        undo->promo_slot = plist_remove(piece, from);
+        plist_add(promo_piece, to);
+        g_state.board[to] = promo_piece;
+        g_state.hash ^= zobrist_pieces[US][promo_type][to];
+        g_state.pawn_hash ^= zobrist_pieces[US][PAWN][from];
+        g_state.material_hash ^=
+            zobrist_pieces[US][PAWN][g_state.piece_count[US][PAWN]];
+        g_state.material_hash ^=
+            zobrist_pieces[US][promo_type][g_state.piece_count[US][promo_type] - 1];
+        g_state.pst_score[US] += US_PST(promo_type, to);
+        /* Adjust material: remove pawn value, add promotion piece value */
+        g_state.material[US] -= material_value[PAWN];
+        g_state.material[US] += material_value[promo_type];
+    } else {
+        /* Normal move: place piece at destination */
+        plist_move(piece, from, to);
+        g_state.board[to] = piece;
+        g_state.hash ^= zobrist_pieces[US][pt][to];
+        g_state.pst_score[US] += US_PST(pt, to);
+        if (pt == PAWN) {
+            g_state.pawn_hash ^= zobrist_pieces[US][PAWN][from] ^
+                                 zobrist_pieces[US][PAWN][to];
+        }
+    }
+
+    /* Update king position */
+    if (pt == KING) {
+        g_state.king_sq[US] = to;
+    }
+
+    /* Handle castling move (move the rook) */
+    if (flags & MF_CASTLE) {
+        u8 rook_from, rook_to;
+        if (to > from) {
+            /* Kingside */
+            rook_from = (u8)(from + 3);
+            rook_to = (u8)(from + 1);
+        } else {
+            /* Queenside */
+            rook_from = (u8)(from - 4);
+            rook_to = (u8)(from - 1);
+        }
+        plist_move(MAKE_PIECE(US, ROOK), rook_from, rook_to);
+        g_state.board[rook_from] = EMPTY;
+        g_state.board[rook_to] = MAKE_PIECE(US, ROOK);
+        g_state.hash ^= zobrist_pieces[US][ROOK][rook_from];
+        g_state.hash ^= zobrist_pieces[US][ROOK][rook_to];
+        g_state.pst_score[US] -= US_PST(ROOK, rook_from);
+        g_state.pst_score[US] += US_PST(ROOK, rook_to);
+    }
+
+    /* Update castling rights */
+    g_state.hash ^= zobrist_castle[g_state.castle_rights];
+    g_state.castle_rights &= castle_mask[from] & castle_mask[to];
+    g_state.hash ^= zobrist_castle[g_state.castle_rights];
+
+    /* Update en passant square */
+    if (g_state.ep_square != SQ_NONE) {
+        g_state.hash ^= zobrist_ep[SQ_FILE(g_state.ep_square)];
+    }
+    if ((flags & MF_PAWNSTART) && pt == PAWN) {
+        g_state.ep_square = (u8)(from + PAWN_UP);
+        g_state.hash ^= zobrist_ep[SQ_FILE(g_state.ep_square)];
+    } else {
+        g_state.ep_square = SQ_NONE;
+    }
+
+#ifdef ATTACK_MAPS
+    am_end(&au);
+#endif
+
+    /* Switch side */
+    g_state.side = THEM;
+    g_state.hash ^= zobrist_side;
+    g_state.ply++;
+    g_state.undo_ply++;
+}
+
+#ifndef COPY_MAKE
+/* Take back m, which US made */
+static void SIDE_FN(unmake_move)(Move m) {
+    u8 from = MOVE_FROM(m);
+    u8 to = MOVE_TO(m);
+    u8 flags = MOVE_FLAGS(m);
+    Undo *undo;
+#ifdef ATTACK_MAPS
+    AttackUpdate au;
+#endif
+
+    /* Switch back */
+    g_state.side = US;
+    g_state.ply--;
+    g_state.undo_ply--;
+    g_state.hash_hist_count--;
+
+    undo = &g_state.undo_stack[g_state.undo_ply];
+
+#ifdef ATTACK_MAPS
+    am_begin(&au, m, US);
+#endif
+
+    /* Restore state */
+    g_state.castle_rights = undo->castle_rights;
+    g_state.ep_square = undo->ep_square;
+    g_state.fifty_clock = undo->fifty_clock;
+    g_state.plies_from_null = undo->plies_from_null;
+    g_state.hash = undo->hash;
+    g_state.pawn_hash = undo->pawn_hash;
+    g_state.material_hash = undo->material_hash;
+    g_state.material[0] = undo->material[0];
+    g_state.material[1] = undo->material[1];
+    g_state.pst_score[0] = undo->pst_score[0];
+    g_state.pst_score[1] = undo->pst_score[1];
+
+    /* Handle castling: move rook back */
+    if (flags & MF_CASTLE) {
+        u8 rook_from, rook_to;
+        if (to > from) {
+            rook_from = (u8)(from + 3);
+            rook_to = (u8)(from + 1);
+        } else {
+            rook_from = (u8)(from - 4);
+            rook_to = (u8)(from - 1);
+        }
+        plist_move(MAKE_PIECE(US, ROOK), rook_to, rook_from);
+        g_state.board[rook_to] = EMPTY;
+        g_state.board[rook_from] = MAKE_PIECE(US, ROOK);
+    }
+
+    /* Handle promotion: piece on 'to' is promoted piece, restore pawn.
+     * The promoted piece was appended last, so dropping it is a pop. */
+    if (flags & MF_PROMO) {
+        plist_pop(g_state.board[to], to);
+        g_state.board[from] = MAKE_PIECE(US, PAWN);
+        plist_restore(MAKE_PIECE(US, PAWN), from, undo->promo_slot);
+    } else {
+        g_state.board[from] = g_state.board[to];
+        plist_move(g_state.board[from], to, from);
+
+        /* Update king position */
+        if (PIECE_TYPE(g_state.board[from]) == KING) {
+            g_state.king_sq[US] = from;
+        }
+    }
+
+    /* Handle en passant: restore captured pawn to correct square */
+    if (flags & MF_EP) {
+        u8 ep_cap_sq = (u8)(to - PAWN_UP);
+        g_state.board[to] = EMPTY;
+        g_state.board[ep_cap_sq] = undo->captured;
+        plist_restore(undo->captured, ep_cap_sq, undo->cap_slot);
+    } else {
+        /* Restore captured piece (or EMPTY) to target square */
+        g_state.board[to] = undo->captured;
+        if (undo->captured != EMPTY) {
+            plist_restore(undo->captured, to, undo->cap_slot);
+        }
+    }
+
+#ifdef ATTACK_MAPS
+    am_end(&au);
+#endif
+}
+#endif /* !COPY_MAKE */
+
+#if !defined(ATTACK_MAPS) && !defined(USE_BITBOARDS)
+/* Is sq attacked by a piece of US? Walks our piece lists; attack_table
+ * rejects impossible geometry in O(1), so rays are only walked for
+ * aligned sliders. */
+static u8 SIDE_FN(is_attacked_by)(u8 sq) {
+    u8 i, from;
+    const u8 *list;
+    const u8 *count = g_state.piece_count[US];
+
+    /* Pawns: two direct probes beat walking up to eight pawns */
+    from = (u8)(sq - PAWN_UP - 1);
+    if (SQ_VALID(from) && g_state.board[from] == MAKE_PIECE(US, PAWN)) return 1;
+    from = (u8)(sq - PAWN_UP + 1);
+    if (SQ_VALID(from) && g_state.board[from] == MAKE_PIECE(US, PAWN)) return 1;
+
+    if (attack_table[ATTACK_INDEX(g_state.king_sq[US], sq)] & ATK_KING) {
+        return 1;
+    }
+
+    list = g_state.piece_list[US][KNIGHT];
+    for (i = 0; i < count[KNIGHT]; i++) {
+        if (attack_table[ATTACK_INDEX(list[i], sq)] & ATK_KNIGHT) return 1;
+    }
+
+    list = g_state.piece_list[US][BISHOP];
+    for (i = 0; i < count[BISHOP]; i++) {
+        if ((attack_table[ATTACK_INDEX(list[i], sq)] & ATK_BISHOP) &&
+            ray_clear(list[i], sq)) return 1;
+    }
+
+    list = g_state.piece_list[US][ROOK];
+    for (i = 0; i < count[ROOK]; i++) {
+        if ((attack_table[ATTACK_INDEX(list[i], sq)] & ATK_ROOK) &&
+            ray_clear(list[i], sq)) return 1;
+    }
+
+    list = g_state.piece_list[US][QUEEN];
+    for (i = 0; i < count[QUEEN]; i++) {
+        if ((attack_table[ATTACK_INDEX(list[i], sq)] & ATK_QUEEN) &&
+            ray_clear(list[i], sq)) return 1;
+    }
+
+    return 0;
+}
+#endif /* !ATTACK_MAPS && !USE_BITBOARDS */
+
+#undef US
+#undef THEM
+#undef PAWN_UP
+#undef US_SQ64
+#undef THEM_SQ64
+#undef SIDE_FN
+#undef US_PST
+#undef THEM_PST
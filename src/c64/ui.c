@@ -189,11 +189,11 @@ u8 ui_get_move(Move *m) {
     base_idx = g_state.move_buf_idx[0];
 
     for (i = 0; i < num_moves; i++) {
-        if (g_state.move_buf[base_idx + i].from == from &&
-            g_state.move_buf[base_idx + i].to == to) {
+        if (MOVE_FROM(g_state.move_buf[base_idx + i]) == from &&
+            MOVE_TO(g_state.move_buf[base_idx + i]) == to) {
             /* For promotions, default to queen */
-            if (g_state.move_buf[base_idx + i].flags & MF_PROMO) {
-                if ((g_state.move_buf[base_idx + i].flags & 0x60) == (3 << 5)) {
+            if (MOVE_FLAGS(g_state.move_buf[base_idx + i]) & MF_PROMO) {
+                if (PROMO_TYPE(MOVE_FLAGS(g_state.move_buf[base_idx + i])) == QUEEN) {
                     /* Queen promotion */
                     *m = g_state.move_buf[base_idx + i];
                     if (board_make_move(*m)) {
@@ -270,7 +270,7 @@ void ui_game_loop(void) {
             /* Search with time limit: 15 seconds on C64 */
             result = search_position(20, 15000);
 
-            if (result.best_move.from == 0 && result.best_move.to == 0) {
+            if (IS_MOVE_NONE(result.best_move)) {
                 ui_status("NO MOVE FOUND!");
                 platform_getkey();
                 break;
@@ -0,0 +1,54 @@
+#include "engine.h"
+#include "board.h"
+
+#ifndef TARGET_C64
+#include <stdlib.h>
+#endif
+
+Engine g_engine_main;
+
+#ifndef TARGET_C64
+__thread Engine *g_engine = &g_engine_main;
+
+Engine *engine_create(Engine *share_tt_with) {
+    Engine *e, *saved;
+
+    e = (Engine *)calloc(1, sizeof(Engine));
+    if (!e) return NULL;
+
+    if (share_tt_with) {
+        e->tt = share_tt_with->tt;
+    } else {
+        /* Zeroed entries are empty: key 0, MOVE_NONE */
+        e->tt = (TTEntry *)calloc(TT_SIZE, sizeof(TTEntry));
+        if (!e->tt) {
+            free(e);
+            return NULL;
+        }
+        e->owns_tt = 1;
+    }
+
+    saved = g_engine;
+    g_engine = e;
+    board_init();
+    g_engine = saved;
+    return e;
+}
+
+void engine_destroy(Engine *e) {
+    u8 i;
+
+    if (!e) return;
+    /* Its Lazy SMP helpers borrow its TT: they go first */
+    for (i = 0; i < e->helper_count; i++) {
+        engine_destroy(e->helpers[i]);
+    }
+    if (g_engine == e) g_engine = &g_engine_main;
+    if (e->owns_tt) free(e->tt);
+    free(e);
+}
+
+void engine_set_current(Engine *e) {
+    g_engine = e ? e : &g_engine_main;
+}
+#endif
@@ -0,0 +1,31 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "types.h"
+
+/*
+ * Engine Contexts
+ * The board, movegen, movesort, search and TT modules work on the current
+ * engine (g_engine, see Engine in types.h). The C64 has exactly one,
+ * g_engine_main. On PC g_engine is per thread and starts out as
+ * g_engine_main; more engines can be created and made current, each with
+ * its own position, search state and killers, and with its own TT or one
+ * shared with another engine.
+ */
+
+#ifndef TARGET_C64
+/* Allocate an engine set to the starting position. Its TT is the one of
+ * share_tt_with, or a new cleared table if that is NULL. Returns NULL if
+ * out of memory. */
+Engine *engine_create(Engine *share_tt_with);
+
+/* Free an engine, its Lazy SMP helpers (search_set_threads) and its TT
+ * unless borrowed. If it is current, the thread falls back to
+ * g_engine_main. Other engines sharing its TT must be destroyed first. */
+void engine_destroy(Engine *e);
+
+/* Make e the current engine of the calling thread (NULL: g_engine_main) */
+void engine_set_current(Engine *e);
+#endif
+
+#endif /* ENGINE_H */
@@ -1,15 +1,13 @@
 #include "movegen.h"
 #include "board.h"
 #include "tables.h"
+#include "bitboard.h"
 
 /* Add a move to the buffer */
 static u16 add_move(u8 ply, u16 count, u8 from, u8 to, u8 flags) {
     u16 idx = g_state.move_buf_idx[ply] + count;
     if (idx >= MOVE_BUF_SIZE) return count; /* overflow protection */
-    g_state.move_buf[idx].from = from;
-    g_state.move_buf[idx].to = to;
-    g_state.move_buf[idx].flags = flags;
-    g_state.move_buf[idx].score = 0;
+    g_state.move_buf[idx] = MOVE_PACK(from, to, flags);
     return count + 1;
 }
 
@@ -23,299 +21,721 @@ static u16 add_promotions(u8 ply, u16 count, u8 from, u8 to, u8 capture) {
     return count;
 }
 
-static u16 generate_pawn_moves(u8 ply, u16 count, u8 side, u8 captures_only) {
-    u8 sq, target, piece;
-    u8 our_pawn = MAKE_PIECE(side, PAWN);
-    s8 forward = (side == WHITE) ? 16 : -16;
-    u8 start_rank = (side == WHITE) ? 1 : 6;
-    u8 promo_rank = (side == WHITE) ? 7 : 0;
-    s8 cap_left  = (side == WHITE) ? 15 : -17;
-    s8 cap_right = (side == WHITE) ? 17 : -15;
-    u8 opp_color = (side == WHITE) ? COLOR_MASK : 0;
+/* Castling moves (board[] and board_is_square_attacked work on either
+ * backend). Squares between king and rook must be empty and the king may
+ * not start in, pass through, or land on an attacked square. */
+static u16 generate_castling(u8 ply, u16 count, u8 side) {
+    u8 opp = side ^ 1;
+    if (side == WHITE) {
+        /* White kingside: e1-g1, f1 and g1 empty, not through check */
+        if ((g_state.castle_rights & CASTLE_WK) &&
+            g_state.board[SQ_F1] == EMPTY &&
+            g_state.board[SQ_G1] == EMPTY &&
+            !board_is_square_attacked(SQ_E1, opp) &&
+            !board_is_square_attacked(SQ_F1, opp) &&
+            !board_is_square_attacked(SQ_G1, opp)) {
+            count = add_move(ply, count, SQ_E1, SQ_G1, MF_CASTLE);
+        }
+        /* White queenside: e1-c1, b1/c1/d1 empty, not through check */
+        if ((g_state.castle_rights & CASTLE_WQ) &&
+            g_state.board[SQ_D1] == EMPTY &&
+            g_state.board[SQ_C1] == EMPTY &&
+            g_state.board[SQ_B1] == EMPTY &&
+            !board_is_square_attacked(SQ_E1, opp) &&
+            !board_is_square_attacked(SQ_D1, opp) &&
+            !board_is_square_attacked(SQ_C1, opp)) {
+            count = add_move(ply, count, SQ_E1, SQ_C1, MF_CASTLE);
+        }
+    } else {
+        /* Black kingside */
+        if ((g_state.castle_rights & CASTLE_BK) &&
+            g_state.board[SQ_F8] == EMPTY &&
+            g_state.board[SQ_G8] == EMPTY &&
+            !board_is_square_attacked(SQ_E8, opp) &&
+            !board_is_square_attacked(SQ_F8, opp) &&
+            !board_is_square_attacked(SQ_G8, opp)) {
+            count = add_move(ply, count, SQ_E8, SQ_G8, MF_CASTLE);
+        }
+        /* Black queenside */
+        if ((g_state.castle_rights & CASTLE_BQ) &&
+            g_state.board[SQ_D8] == EMPTY &&
+            g_state.board[SQ_C8] == EMPTY &&
+            g_state.board[SQ_B8] == EMPTY &&
+            !board_is_square_attacked(SQ_E8, opp) &&
+            !board_is_square_attacked(SQ_D8, opp) &&
+            !board_is_square_attacked(SQ_C8, opp)) {
+            count = add_move(ply, count, SQ_E8, SQ_C8, MF_CASTLE);
+        }
+    }
+    return count;
+}
 
-    for (sq = 0; sq < 128; sq++) {
-        if (!SQ_VALID(sq)) continue;
-        if (g_state.board[sq] != our_pawn) continue;
+/* What to generate: captures (with en passant and capture-promotions),
+ * quiets (pushes, push-promotions, castling), or both */
+#define GEN_CAPTURES 0x01
+#define GEN_QUIETS   0x02
+#define GEN_ALL      (GEN_CAPTURES | GEN_QUIETS)
 
-        /* Captures */
-        target = (u8)((s8)sq + cap_left);
-        if (SQ_VALID(target)) {
-            piece = g_state.board[target];
-            if (piece != EMPTY && (piece & COLOR_MASK) == opp_color) {
-                if (SQ_RANK(target) == promo_rank) {
-                    count = add_promotions(ply, count, sq, target, 1);
-                } else {
-                    count = add_move(ply, count, sq, target, MF_CAPTURE);
-                }
+/* Color-specialized pawn generators generate_pawns_white/_black */
+#define SIDE WHITE
+#include "movegen_side.h"
+#undef SIDE
+#define SIDE BLACK
+#include "movegen_side.h"
+#undef SIDE
+
+#ifndef USE_BITBOARDS
+
+/* --- 0x88 generators (C64 build) --- */
+
+/* Knight and king steps */
+static u16 generate_leaper(u8 ply, u16 count, u8 side, u8 sq,
+                           const s8 *offsets, u8 gen) {
+    u8 target, piece, i;
+    u8 our_color = side ? COLOR_MASK : 0;
+
+    for (i = 0; i < 8; i++) {
+        target = (u8)((s8)sq + offsets[i]);
+        if (!SQ_VALID(target)) continue;
+        piece = g_state.board[target];
+        if (piece != EMPTY) {
+            if ((piece & COLOR_MASK) != our_color && (gen & GEN_CAPTURES)) {
+                count = add_move(ply, count, sq, target, MF_CAPTURE);
             }
+        } else if (gen & GEN_QUIETS) {
+            count = add_move(ply, count, sq, target, MF_NONE);
         }
+    }
+    return count;
+}
 
-        target = (u8)((s8)sq + cap_right);
-        if (SQ_VALID(target)) {
+static u16 generate_slider(u8 ply, u16 count, u8 side, u8 sq,
+                           const s8 *dirs, u8 num_dirs, u8 gen) {
+    u8 target, piece, i;
+    u8 our_color = side ? COLOR_MASK : 0;
+    s8 dir;
+
+    for (i = 0; i < num_dirs; i++) {
+        dir = dirs[i];
+        target = (u8)((s8)sq + dir);
+        while (SQ_VALID(target)) {
             piece = g_state.board[target];
-            if (piece != EMPTY && (piece & COLOR_MASK) == opp_color) {
-                if (SQ_RANK(target) == promo_rank) {
-                    count = add_promotions(ply, count, sq, target, 1);
-                } else {
+            if (piece != EMPTY) {
+                if ((piece & COLOR_MASK) != our_color && (gen & GEN_CAPTURES)) {
                     count = add_move(ply, count, sq, target, MF_CAPTURE);
                 }
+                break;
             }
-        }
-
-        /* En passant */
-        if (g_state.ep_square != SQ_NONE) {
-            target = (u8)((s8)sq + cap_left);
-            if (target == g_state.ep_square) {
-                count = add_move(ply, count, sq, target, (u8)(MF_CAPTURE | MF_EP));
-            }
-            target = (u8)((s8)sq + cap_right);
-            if (target == g_state.ep_square) {
-                count = add_move(ply, count, sq, target, (u8)(MF_CAPTURE | MF_EP));
+            if (gen & GEN_QUIETS) {
+                count = add_move(ply, count, sq, target, MF_NONE);
             }
+            target = (u8)((s8)target + dir);
         }
+    }
+    return count;
+}
 
-        if (captures_only) continue;
+/* Moves of the non-pawn piece on sq (which must be ours) */
+static u16 generate_piece(u8 ply, u16 count, u8 side, u8 sq, u8 gen) {
+    switch (PIECE_TYPE(g_state.board[sq])) {
+        case KNIGHT: return generate_leaper(ply, count, side, sq, knight_offsets, gen);
+        case BISHOP: return generate_slider(ply, count, side, sq, bishop_offsets, 4, gen);
+        case ROOK:   return generate_slider(ply, count, side, sq, rook_offsets, 4, gen);
+        case QUEEN:  return generate_slider(ply, count, side, sq, king_offsets, 8, gen);
+        case KING:
+            count = generate_leaper(ply, count, side, sq, king_offsets, gen);
+            if (gen & GEN_QUIETS) {
+                count = generate_castling(ply, count, side);
+            }
+            return count;
+    }
+    return count;
+}
 
-        /* Forward one square */
-        target = (u8)((s8)sq + forward);
-        if (SQ_VALID(target) && g_state.board[target] == EMPTY) {
-            if (SQ_RANK(target) == promo_rank) {
-                count = add_promotions(ply, count, sq, target, 0);
-            } else {
-                count = add_move(ply, count, sq, target, MF_NONE);
+static u16 generate_all(u8 ply, u16 count, u8 side, u8 gen) {
+    u8 pt, n;
 
-                /* Forward two squares from starting rank */
-                if (SQ_RANK(sq) == start_rank) {
-                    u8 target2 = (u8)((s8)target + forward);
-                    if (g_state.board[target2] == EMPTY) {
-                        count = add_move(ply, count, sq, target2, MF_PAWNSTART);
-                    }
-                }
-            }
+    /* Pawns, knights, bishops, rooks, queens, then the king */
+    count = (side == WHITE) ? generate_pawns_white(ply, count, gen)
+                            : generate_pawns_black(ply, count, gen);
+    for (pt = KNIGHT; pt <= KING; pt++) {
+        for (n = 0; n < g_state.piece_count[side][pt]; n++) {
+            count = generate_piece(ply, count, side, g_state.piece_list[side][pt][n], gen);
         }
     }
     return count;
 }
 
-static u16 generate_knight_moves(u8 ply, u16 count, u8 side, u8 captures_only) {
-    u8 sq, target, piece, i;
-    u8 our_knight = MAKE_PIECE(side, KNIGHT);
-    u8 our_color = side ? COLOR_MASK : 0;
+#else /* USE_BITBOARDS */
 
-    for (sq = 0; sq < 128; sq++) {
-        if (!SQ_VALID(sq)) continue;
-        if (g_state.board[sq] != our_knight) continue;
+/* --- Bitboard generators (PC build) --- */
 
-        for (i = 0; i < 8; i++) {
-            target = (u8)((s8)sq + knight_offsets[i]);
-            if (!SQ_VALID(target)) continue;
-            piece = g_state.board[target];
-            if (piece != EMPTY && (piece & COLOR_MASK) == our_color) continue;
+/* Add a move from 'from' to every square in targets */
+static u16 add_targets(u8 ply, u16 count, u8 from, Bitboard targets, Bitboard them) {
+    u8 to64;
+    while (targets) {
+        to64 = bb_pop_lsb(&targets);
+        count = add_move(ply, count, from, (u8)SQ_FROM64(to64),
+                         (them & BB_SQ(to64)) ? MF_CAPTURE : MF_NONE);
+    }
+    return count;
+}
 
-            if (piece != EMPTY) {
-                count = add_move(ply, count, sq, target, MF_CAPTURE);
-            } else if (!captures_only) {
-                count = add_move(ply, count, sq, target, MF_NONE);
-            }
+/* Moves of our non-pawn piece of type pt on from64 */
+static u16 generate_piece_bb(u8 ply, u16 count, u8 side, u8 pt, u8 from64, u8 gen) {
+    Bitboard them = g_state.bb_color[side ^ 1];
+    Bitboard occ = g_state.bb_occupied;
+    Bitboard targets = 0, attacks;
+    u8 from = (u8)SQ_FROM64(from64);
+
+    if (gen & GEN_CAPTURES) targets |= them;
+    if (gen & GEN_QUIETS) targets |= ~occ;
+
+    switch (pt) {
+        case KNIGHT: attacks = bb_knight_attacks[from64]; break;
+        case BISHOP: attacks = bb_bishop_attacks(from64, occ); break;
+        case ROOK:   attacks = bb_rook_attacks(from64, occ); break;
+        case QUEEN:  attacks = bb_bishop_attacks(from64, occ) |
+                               bb_rook_attacks(from64, occ); break;
+        default:     attacks = bb_king_attacks[from64]; break;
+    }
+    count = add_targets(ply, count, from, attacks & targets, them);
+    if (pt == KING && (gen & GEN_QUIETS)) {
+        count = generate_castling(ply, count, side);
+    }
+    return count;
+}
+
+static u16 generate_all(u8 ply, u16 count, u8 side, u8 gen) {
+    Bitboard pieces;
+    u8 pt;
+
+    /* Pawns, knights, bishops, rooks, queens, then the king */
+    count = (side == WHITE) ? generate_pawns_white(ply, count, gen)
+                            : generate_pawns_black(ply, count, gen);
+    for (pt = KNIGHT; pt <= KING; pt++) {
+        pieces = g_state.bb_pieces[side][pt];
+        while (pieces) {
+            count = generate_piece_bb(ply, count, side, pt, bb_pop_lsb(&pieces), gen);
         }
     }
     return count;
 }
 
-static u16 generate_sliding_moves(u8 ply, u16 count, u8 side,
-                                   const s8 *dirs, u8 num_dirs,
-                                   u8 piece_type, u8 captures_only) {
-    u8 sq, target, piece, i;
-    u8 our_piece = MAKE_PIECE(side, piece_type);
+#endif /* USE_BITBOARDS */
+
+/* --- Legal move filter (both backends) ---
+ * Checkers and pinned pieces are found once per node by walking the eight
+ * king rays on the 0x88 board; each pseudo-legal move is then accepted or
+ * dropped without making it. */
+
+typedef struct {
+    u8 num_checkers;  /* 0, 1 or 2 */
+    u8 check_sq;      /* square of the checker (when num_checkers == 1) */
+    s8 check_dir;     /* step from the king to a slider checker, else 0 */
+    u8 num_pins;
+    u8 pin_sq[8];     /* our pinned pieces ... */
+    s8 pin_dir[8];    /* ... and the step from the king along their ray */
+} CheckInfo;
+
+static void compute_check_info(u8 side, CheckInfo *ci) {
+    u8 ksq = g_state.king_sq[side];
     u8 our_color = side ? COLOR_MASK : 0;
+    u8 enemy_pawn = MAKE_PIECE(side ^ 1, PAWN);
+    u8 enemy_knight = MAKE_PIECE(side ^ 1, KNIGHT);
+    u8 i, sq, piece, pt, pinned;
     s8 dir;
 
-    for (sq = 0; sq < 128; sq++) {
-        if (!SQ_VALID(sq)) continue;
-        if (g_state.board[sq] != our_piece) continue;
-
-        for (i = 0; i < num_dirs; i++) {
-            dir = dirs[i];
-            target = (u8)((s8)sq + dir);
-            while (SQ_VALID(target)) {
-                piece = g_state.board[target];
-                if (piece != EMPTY) {
-                    if ((piece & COLOR_MASK) != our_color) {
-                        count = add_move(ply, count, sq, target, MF_CAPTURE);
+    ci->num_checkers = 0;
+    ci->check_dir = 0;
+    ci->num_pins = 0;
+
+    /* Pawn and knight checks */
+    for (i = 0; i < 2; i++) {
+        sq = (u8)(ksq + (side == WHITE ? (i ? 17 : 15) : (i ? -17 : -15)));
+        if (SQ_VALID(sq) && g_state.board[sq] == enemy_pawn) {
+            ci->num_checkers++;
+            ci->check_sq = sq;
+        }
+    }
+    for (i = 0; i < 8; i++) {
+        sq = (u8)(ksq + knight_offsets[i]);
+        if (SQ_VALID(sq) && g_state.board[sq] == enemy_knight) {
+            ci->num_checkers++;
+            ci->check_sq = sq;
+        }
+    }
+
+    /* Slider checks and pins: the first piece on each ray is a checker if
+     * it is a matching enemy slider, or pinned if it is ours and the next
+     * piece is one. king_offsets[1,3,4,6] are orthogonal. */
+    for (i = 0; i < 8; i++) {
+        dir = king_offsets[i];
+        pinned = SQ_NONE;
+        sq = (u8)(ksq + dir);
+        while (SQ_VALID(sq)) {
+            piece = g_state.board[sq];
+            if (piece != EMPTY) {
+                if ((piece & COLOR_MASK) == our_color) {
+                    if (pinned != SQ_NONE) break;
+                    pinned = sq;
+                } else {
+                    pt = PIECE_TYPE(piece);
+                    if (pt == QUEEN ||
+                        pt == ((i == 1 || i == 3 || i == 4 || i == 6) ? ROOK : BISHOP)) {
+                        if (pinned == SQ_NONE) {
+                            ci->num_checkers++;
+                            ci->check_sq = sq;
+                            ci->check_dir = dir;
+                        } else {
+                            ci->pin_sq[ci->num_pins] = pinned;
+                            ci->pin_dir[ci->num_pins] = dir;
+                            ci->num_pins++;
+                        }
                     }
                     break;
                 }
-                if (!captures_only) {
-                    count = add_move(ply, count, sq, target, MF_NONE);
-                }
-                target = (u8)((s8)target + dir);
             }
+            sq = (u8)(sq + dir);
         }
     }
-    return count;
 }
 
-static u16 generate_king_moves(u8 ply, u16 count, u8 side, u8 captures_only) {
-    static const s8 king_dirs[8] = { -17, -16, -15, -1, 1, 15, 16, 17 };
-    u8 sq = g_state.king_sq[side];
-    u8 target, piece, i;
+/* Is 'to' attacked once the king has left ksq? Sliders checking the king
+ * along the line of the move still cover the square behind it. */
+static u8 king_target_attacked(u8 ksq, u8 to, u8 opp) {
+    s8 dir = (s8)(ksq - to);
+    u8 sq, piece, pt;
+
+    if (board_is_square_attacked(to, opp)) return 1;
+
+    for (sq = (u8)(ksq + dir); SQ_VALID(sq); sq = (u8)(sq + dir)) {
+        piece = g_state.board[sq];
+        if (piece == EMPTY) continue;
+        if (PIECE_COLOR(piece) != opp) return 0;
+        pt = PIECE_TYPE(piece);
+        return pt == QUEEN ||
+               pt == ((dir == 1 || dir == -1 || dir == 16 || dir == -16) ? ROOK : BISHOP);
+    }
+    return 0;
+}
+
+/* Is the pseudo-legal move from-to (with flags) legal, given the side's
+ * check info? */
+static u8 legal_by_ci(const CheckInfo *ci, u8 ksq, u8 from, u8 to, u8 flags) {
+    u8 j, legal;
+    Move m;
+
+    if (from == ksq) {
+        /* Castling was generated legal */
+        if (flags & MF_CASTLE) return 1;
+        return !king_target_attacked(ksq, to, g_state.side ^ 1);
+    }
+    if (flags & MF_EP) {
+        /* En passant removes two pawns from one rank, which can
+         * uncover the king in ways a pin test misses: play it out */
+        m = MOVE_PACK(from, to, flags);
+        legal = board_make_move(m);
+        if (legal) board_unmake_move(m);
+        return legal;
+    }
+    if (ci->num_checkers > 1) return 0;
+
+    /* Single check: capture the checker or block the ray */
+    if (ci->num_checkers == 1 && to != ci->check_sq &&
+        !(ci->check_dir != 0 &&
+          delta_table[ATTACK_INDEX(to, ksq)] == ci->check_dir &&
+          delta_table[ATTACK_INDEX(ci->check_sq, to)] == ci->check_dir)) {
+        return 0;
+    }
+    /* Pinned pieces stay on the line through the king */
+    for (j = 0; j < ci->num_pins; j++) {
+        if (ci->pin_sq[j] == from &&
+            delta_table[ATTACK_INDEX(to, ksq)] != ci->pin_dir[j]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Compact moves [start, count) of this ply down to the legal ones
+ * (order is kept). Returns the new count. */
+static u16 filter_legal(u8 ply, u16 start, u16 count) {
+    CheckInfo ci;
+    Move *moves = &g_state.move_buf[g_state.move_buf_idx[ply]];
+    u8 ksq = g_state.king_sq[g_state.side];
+    u16 i, n = start;
+
+    compute_check_info(g_state.side, &ci);
+
+    for (i = start; i < count; i++) {
+        Move m = moves[i];
+        if (legal_by_ci(&ci, ksq, MOVE_FROM(m), MOVE_TO(m), MOVE_FLAGS(m))) {
+            moves[n++] = m;
+        }
+    }
+    return n;
+}
+
+/* --- Legal move counting (both backends) ---
+ * Walks the side's pieces on the 0x88 board and tests each target with
+ * legal_by_ci as it is found. No Move is written to move_buf, so these
+ * can run in the middle of a search. Each returns the updated count n,
+ * stopping as soon as it reaches limit. */
+
+static u16 count_pawn(const CheckInfo *ci, u8 ksq, u8 sq, u16 n, u16 limit) {
+    u8 side = g_state.side;
+    s8 forward = (side == WHITE) ? 16 : -16;
+    u8 our_color = side ? COLOR_MASK : 0;
+    u8 fwd = (u8)(sq + forward);
+    u8 i, to, flags, piece;
+    u16 weight;
+
+    /* A promotion counts once per promotion piece */
+    weight = (SQ_RANK(fwd) == ((side == WHITE) ? 7 : 0)) ? 4 : 1;
+
+    /* Captures and en passant */
+    for (i = 0; i < 2; i++) {
+        to = (u8)(fwd + (i ? 1 : -1));
+        if (!SQ_VALID(to)) continue;
+        piece = g_state.board[to];
+        if (to == g_state.ep_square) {
+            flags = MF_CAPTURE | MF_EP;
+        } else if (piece != EMPTY && (piece & COLOR_MASK) != our_color) {
+            flags = MF_CAPTURE;
+        } else {
+            continue;
+        }
+        if (legal_by_ci(ci, ksq, sq, to, flags)) {
+            n += weight;
+            if (n >= limit) return n;
+        }
+    }
+
+    /* Pushes */
+    if (g_state.board[fwd] != EMPTY) return n;
+    if (legal_by_ci(ci, ksq, sq, fwd, MF_NONE)) {
+        n += weight;
+        if (n >= limit) return n;
+    }
+    to = (u8)(fwd + forward);
+    if (SQ_RANK(sq) == ((side == WHITE) ? 1 : 6) &&
+        g_state.board[to] == EMPTY &&
+        legal_by_ci(ci, ksq, sq, to, MF_PAWNSTART)) {
+        n++;
+    }
+    return n;
+}
+
+static u16 count_piece(const CheckInfo *ci, u8 ksq, u8 sq, u8 pt, u16 n, u16 limit) {
+    u8 our_color = g_state.side ? COLOR_MASK : 0;
+    const s8 *offsets = king_offsets;
+    u8 num_dirs = 8, slide = 1;
+    u8 i, to, piece;
+
+    switch (pt) {
+        case KNIGHT: offsets = knight_offsets; slide = 0; break;
+        case BISHOP: offsets = bishop_offsets; num_dirs = 4; break;
+        case ROOK:   offsets = rook_offsets; num_dirs = 4; break;
+    }
+
+    for (i = 0; i < num_dirs; i++) {
+        to = (u8)(sq + offsets[i]);
+        while (SQ_VALID(to)) {
+            piece = g_state.board[to];
+            if (piece != EMPTY && (piece & COLOR_MASK) == our_color) break;
+            if (legal_by_ci(ci, ksq, sq, to, piece != EMPTY ? MF_CAPTURE : MF_NONE) &&
+                ++n >= limit) {
+                return n;
+            }
+            if (piece != EMPTY || !slide) break;
+            to = (u8)(to + offsets[i]);
+        }
+    }
+    return n;
+}
+
+static u16 count_legal(u16 limit) {
+    CheckInfo ci;
+    u8 side = g_state.side;
+    u8 ksq = g_state.king_sq[side];
     u8 our_color = side ? COLOR_MASK : 0;
+    u8 i, pt, k, to, piece;
+    u16 n = 0;
+
+    compute_check_info(side, &ci);
 
+    /* King steps first: often legal, and all there is in double check */
     for (i = 0; i < 8; i++) {
-        target = (u8)((s8)sq + king_dirs[i]);
-        if (!SQ_VALID(target)) continue;
-        piece = g_state.board[target];
+        to = (u8)(ksq + king_offsets[i]);
+        if (!SQ_VALID(to)) continue;
+        piece = g_state.board[to];
         if (piece != EMPTY && (piece & COLOR_MASK) == our_color) continue;
-
-        if (piece != EMPTY) {
-            count = add_move(ply, count, sq, target, MF_CAPTURE);
-        } else if (!captures_only) {
-            count = add_move(ply, count, sq, target, MF_NONE);
+        if (!king_target_attacked(ksq, to, side ^ 1) && ++n >= limit) return n;
+    }
+    if (ci.num_checkers > 1) return n;
+
+    /* Castling: board_is_pseudo_legal checks rights, path and attacks */
+    if (ksq == ((side == WHITE) ? SQ_E1 : SQ_E8)) {
+        for (i = 0; i < 2; i++) {
+            to = (u8)(i ? ksq - 2 : ksq + 2);
+            if (board_is_pseudo_legal(MOVE_PACK(ksq, to, MF_CASTLE)) &&
+                ++n >= limit) {
+                return n;
+            }
         }
     }
 
-    /* Castling (not in captures-only mode) */
-    if (!captures_only) {
-        u8 opp = side ^ 1;
-        if (side == WHITE) {
-            /* White kingside: e1-g1, f1 and g1 empty, not through check */
-            if ((g_state.castle_rights & CASTLE_WK) &&
-                g_state.board[SQ_F1] == EMPTY &&
-                g_state.board[SQ_G1] == EMPTY &&
-                !board_is_square_attacked(SQ_E1, opp) &&
-                !board_is_square_attacked(SQ_F1, opp) &&
-                !board_is_square_attacked(SQ_G1, opp)) {
-                count = add_move(ply, count, SQ_E1, SQ_G1, MF_CASTLE);
+    for (pt = PAWN; pt < KING; pt++) {
+        for (k = 0; k < g_state.piece_count[side][pt]; k++) {
+            u8 sq = g_state.piece_list[side][pt][k];
+            if (pt == PAWN) {
+                n = count_pawn(&ci, ksq, sq, n, limit);
+            } else {
+                n = count_piece(&ci, ksq, sq, pt, n, limit);
             }
-            /* White queenside: e1-c1, b1/c1/d1 empty, not through check */
-            if ((g_state.castle_rights & CASTLE_WQ) &&
-                g_state.board[SQ_D1] == EMPTY &&
-                g_state.board[SQ_C1] == EMPTY &&
-                g_state.board[SQ_B1] == EMPTY &&
-                !board_is_square_attacked(SQ_E1, opp) &&
-                !board_is_square_attacked(SQ_D1, opp) &&
-                !board_is_square_attacked(SQ_C1, opp)) {
-                count = add_move(ply, count, SQ_E1, SQ_C1, MF_CASTLE);
+            if (n >= limit) return n;
+        }
+    }
+    return n;
+}
+
+/* --- Check evasions (both backends) --- */
+
+static u8 is_pinned(const CheckInfo *ci, u8 sq) {
+    u8 j;
+    for (j = 0; j < ci->num_pins; j++) {
+        if (ci->pin_sq[j] == sq) return 1;
+    }
+    return 0;
+}
+
+/* attack_table bit for each non-pawn piece type */
+static const u8 atk_bit[7] = {
+    0, 0, ATK_KNIGHT, ATK_BISHOP, ATK_ROOK, ATK_QUEEN, ATK_KING
+};
+
+/* Add every move of an unpinned non-king piece to 'to' (the checker's
+ * square or an empty square on the check ray) */
+static u16 add_evasions_to(u8 ply, u16 count, u8 side, u8 to, const CheckInfo *ci) {
+    u8 capture = g_state.board[to] != EMPTY;
+    u8 promo_rank = (side == WHITE) ? 7 : 0;
+    u8 pawn = MAKE_PIECE(side, PAWN);
+    u8 pt, n, sq, i;
+    s8 step;
+
+    /* Pawns: captures onto the checker, pushes onto the ray */
+    if (capture) {
+        for (i = 0; i < 2; i++) {
+            sq = (u8)(to - (side == WHITE ? (i ? 17 : 15) : (i ? -17 : -15)));
+            if (!SQ_VALID(sq) || g_state.board[sq] != pawn || is_pinned(ci, sq)) continue;
+            if (SQ_RANK(to) == promo_rank) {
+                count = add_promotions(ply, count, sq, to, 1);
+            } else {
+                count = add_move(ply, count, sq, to, MF_CAPTURE);
             }
-        } else {
-            /* Black kingside */
-            if ((g_state.castle_rights & CASTLE_BK) &&
-                g_state.board[SQ_F8] == EMPTY &&
-                g_state.board[SQ_G8] == EMPTY &&
-                !board_is_square_attacked(SQ_E8, opp) &&
-                !board_is_square_attacked(SQ_F8, opp) &&
-                !board_is_square_attacked(SQ_G8, opp)) {
-                count = add_move(ply, count, SQ_E8, SQ_G8, MF_CASTLE);
+        }
+    } else {
+        s8 forward = (side == WHITE) ? 16 : -16;
+        sq = (u8)(to - forward);
+        if (SQ_VALID(sq) && g_state.board[sq] == pawn) {
+            if (!is_pinned(ci, sq)) {
+                if (SQ_RANK(to) == promo_rank) {
+                    count = add_promotions(ply, count, sq, to, 0);
+                } else {
+                    count = add_move(ply, count, sq, to, MF_NONE);
+                }
             }
-            /* Black queenside */
-            if ((g_state.castle_rights & CASTLE_BQ) &&
-                g_state.board[SQ_D8] == EMPTY &&
-                g_state.board[SQ_C8] == EMPTY &&
-                g_state.board[SQ_B8] == EMPTY &&
-                !board_is_square_attacked(SQ_E8, opp) &&
-                !board_is_square_attacked(SQ_D8, opp) &&
-                !board_is_square_attacked(SQ_C8, opp)) {
-                count = add_move(ply, count, SQ_E8, SQ_C8, MF_CASTLE);
+        } else if (SQ_VALID(sq) && g_state.board[sq] == EMPTY &&
+                   SQ_RANK(to) == (side == WHITE ? 3 : 4)) {
+            sq = (u8)(sq - forward);
+            if (g_state.board[sq] == pawn && !is_pinned(ci, sq)) {
+                count = add_move(ply, count, sq, to, MF_PAWNSTART);
             }
         }
     }
 
+    /* Pieces: attack_table geometry, then a clear path for sliders */
+    for (pt = KNIGHT; pt <= QUEEN; pt++) {
+        for (n = 0; n < g_state.piece_count[side][pt]; n++) {
+            sq = g_state.piece_list[side][pt][n];
+            if (!(attack_table[ATTACK_INDEX(sq, to)] & atk_bit[pt])) continue;
+            if (pt != KNIGHT) {
+                step = delta_table[ATTACK_INDEX(sq, to)];
+                for (i = (u8)(to + step); i != sq; i = (u8)(i + step)) {
+                    if (g_state.board[i] != EMPTY) break;
+                }
+                if (i != sq) continue;
+            }
+            if (is_pinned(ci, sq)) continue;
+            count = add_move(ply, count, sq, to, capture ? MF_CAPTURE : MF_NONE);
+        }
+    }
     return count;
 }
 
-static u16 generate_queen_moves(u8 ply, u16 count, u8 side, u8 captures_only) {
-    /* Queen combines bishop + rook directions */
-    static const s8 queen_dirs[8] = { -17, -16, -15, -1, 1, 15, 16, 17 };
-    u8 sq, target, piece, i;
-    u8 our_queen = MAKE_PIECE(side, QUEEN);
+static u16 generate_evasions(u8 ply, u8 side) {
+    CheckInfo ci;
+    u8 ksq = g_state.king_sq[side];
     u8 our_color = side ? COLOR_MASK : 0;
-    s8 dir;
+    u8 i, to, piece;
+    u16 count = 0;
 
-    for (sq = 0; sq < 128; sq++) {
-        if (!SQ_VALID(sq)) continue;
-        if (g_state.board[sq] != our_queen) continue;
-
-        for (i = 0; i < 8; i++) {
-            dir = queen_dirs[i];
-            target = (u8)((s8)sq + dir);
-            while (SQ_VALID(target)) {
-                piece = g_state.board[target];
-                if (piece != EMPTY) {
-                    if ((piece & COLOR_MASK) != our_color) {
-                        count = add_move(ply, count, sq, target, MF_CAPTURE);
-                    }
-                    break;
-                }
-                if (!captures_only) {
-                    count = add_move(ply, count, sq, target, MF_NONE);
-                }
-                target = (u8)((s8)target + dir);
+    compute_check_info(side, &ci);
+
+    /* King steps (including capturing the checker) */
+    for (i = 0; i < 8; i++) {
+        to = (u8)(ksq + king_offsets[i]);
+        if (!SQ_VALID(to)) continue;
+        piece = g_state.board[to];
+        if (piece != EMPTY && (piece & COLOR_MASK) == our_color) continue;
+        if (king_target_attacked(ksq, to, side ^ 1)) continue;
+        count = add_move(ply, count, ksq, to, piece != EMPTY ? MF_CAPTURE : MF_NONE);
+    }
+
+    /* In double check only the king can move */
+    if (ci.num_checkers > 1) return count;
+
+    /* Capture the checker, or interpose on a slider's ray */
+    count = add_evasions_to(ply, count, side, ci.check_sq, &ci);
+    if (ci.check_dir != 0) {
+        for (to = (u8)(ksq + ci.check_dir); to != ci.check_sq;
+             to = (u8)(to + ci.check_dir)) {
+            count = add_evasions_to(ply, count, side, to, &ci);
+        }
+    }
+
+    /* En passant may capture a checking pawn; too rare to reason about
+     * discoveries here, so test it by making it */
+    if (g_state.ep_square != SQ_NONE) {
+        u8 pawn = MAKE_PIECE(side, PAWN);
+        u8 from;
+        Move m;
+        to = g_state.ep_square;
+        for (i = 0; i < 2; i++) {
+            from = (u8)(to - (side == WHITE ? (i ? 17 : 15) : (i ? -17 : -15)));
+            if (!SQ_VALID(from) || g_state.board[from] != pawn) continue;
+            m = MOVE_PACK(from, to, MF_CAPTURE | MF_EP);
+            if (board_make_move(m)) {
+                board_unmake_move(m);
+                count = add_move(ply, count, from, to, (u8)(MF_CAPTURE | MF_EP));
             }
         }
     }
+
     return count;
 }
 
-u16 movegen_generate(u8 ply) {
-    u16 count = 0;
-    u8 side = g_state.side;
-
-    /* Set start index for this ply's moves */
+/* Generate into this ply's slot from index 'count' on and fix up the
+ * next ply's start index */
+static u16 generate_at(u8 ply, u16 count, u8 gen) {
     if (ply == 0) {
         g_state.move_buf_idx[0] = 0;
     }
-    g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply]; /* will be updated */
+    count = generate_all(ply, count, g_state.side, gen);
+    g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply] + count;
+    return count;
+}
 
-    count = generate_pawn_moves(ply, count, side, 0);
-    count = generate_knight_moves(ply, count, side, 0);
-    count = generate_sliding_moves(ply, count, side, bishop_offsets, 4, BISHOP, 0);
-    count = generate_sliding_moves(ply, count, side, rook_offsets, 4, ROOK, 0);
-    count = generate_queen_moves(ply, count, side, 0);
-    count = generate_king_moves(ply, count, side, 0);
+u16 movegen_generate(u8 ply) {
+    return generate_at(ply, 0, GEN_ALL);
+}
 
-    /* Update next ply's start index */
-    g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply] + count;
+u16 movegen_generate_captures(u8 ply) {
+    return generate_at(ply, 0, GEN_CAPTURES);
+}
+
+u8 movegen_has_legal_move(void) {
+    return count_legal(1) != 0;
+}
+
+u16 movegen_count_legal(void) {
+    return count_legal(0xFFFF);
+}
 
+/* Generate with gen after the first 'start' moves, keep the legal ones */
+static u16 generate_legal_at(u8 ply, u16 start, u8 gen) {
+    u16 count = generate_at(ply, start, gen);
+
+    count = filter_legal(ply, start, count);
+    g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply] + count;
     return count;
 }
 
-u16 movegen_generate_captures(u8 ply) {
-    u16 count = 0;
+u16 movegen_generate_legal(u8 ply) {
+    return generate_legal_at(ply, 0, GEN_ALL);
+}
+
+u16 movegen_generate_legal_captures(u8 ply) {
+    return generate_legal_at(ply, 0, GEN_CAPTURES);
+}
+
+u16 movegen_append_legal_quiets(u8 ply, u16 count) {
+    return generate_legal_at(ply, count, GEN_QUIETS);
+}
+
+u8 movegen_is_legal(Move m) {
     u8 side = g_state.side;
+    u8 ksq = g_state.king_sq[side];
+    u8 from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+    u8 sq, piece, pt, legal;
+    s8 dir;
+
+    if (!board_is_pseudo_legal(m)) return 0;
+
+    /* Castling was checked through and out of check */
+    if (flags & MF_CASTLE) return 1;
+    if (from == ksq) return !king_target_attacked(ksq, to, side ^ 1);
+
+    /* En passant and evasions are rare here: play them out */
+    if ((flags & MF_EP) || board_in_check()) {
+        legal = board_make_move(m);
+        if (legal) board_unmake_move(m);
+        return legal;
+    }
+
+    /* Not in check: only a pin along the line king-from can be broken */
+    dir = delta_table[ATTACK_INDEX(from, ksq)];
+    if (dir == 0 || delta_table[ATTACK_INDEX(to, ksq)] == dir) return 1;
+    for (sq = (u8)(ksq + dir); sq != from; sq = (u8)(sq + dir)) {
+        if (g_state.board[sq] != EMPTY) return 1;
+    }
+    for (sq = (u8)(from + dir); SQ_VALID(sq); sq = (u8)(sq + dir)) {
+        piece = g_state.board[sq];
+        if (piece == EMPTY) continue;
+        if (PIECE_COLOR(piece) == side) return 1;
+        pt = PIECE_TYPE(piece);
+        return !(pt == QUEEN ||
+                 pt == ((dir == 1 || dir == -1 || dir == 16 || dir == -16) ? ROOK : BISHOP));
+    }
+    return 1;
+}
+
+u16 movegen_generate_evasions(u8 ply) {
+    u16 count;
 
     if (ply == 0) {
         g_state.move_buf_idx[0] = 0;
     }
     g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply];
 
-    count = generate_pawn_moves(ply, count, side, 1);
-    count = generate_knight_moves(ply, count, side, 1);
-    count = generate_sliding_moves(ply, count, side, bishop_offsets, 4, BISHOP, 1);
-    count = generate_sliding_moves(ply, count, side, rook_offsets, 4, ROOK, 1);
-    count = generate_queen_moves(ply, count, side, 1);
-    count = generate_king_moves(ply, count, side, 1);
+    count = generate_evasions(ply, g_state.side);
 
     g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply] + count;
 
     return count;
 }
 
-u8 movegen_has_legal_move(void) {
-    u16 num_moves, i;
-    u16 base_idx;
-
-    /* Use a high ply slot to avoid disturbing active search */
-    u8 ply = MAX_PLY - 2;
-    g_state.move_buf_idx[ply] = MOVE_BUF_SIZE - MAX_MOVES;
-
-    num_moves = movegen_generate(ply);
-    base_idx = g_state.move_buf_idx[ply];
+u16 movegen_generate_quiet_checks(u8 ply) {
+    u16 count = generate_legal_at(ply, 0, GEN_QUIETS);
+    Move *moves = &g_state.move_buf[g_state.move_buf_idx[ply]];
+    u16 i, n = 0;
 
-    for (i = 0; i < num_moves; i++) {
-        if (board_make_move(g_state.move_buf[base_idx + i])) {
-            board_unmake_move(g_state.move_buf[base_idx + i]);
-            return 1;
-        }
+    for (i = 0; i < count; i++) {
+        if (MOVE_FLAGS(moves[i]) & MF_PROMO) continue;
+        if (board_gives_check(moves[i])) moves[n++] = moves[i];
     }
-    return 0;
+
+    g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply] + n;
+    return n;
 }
@@ -6,10 +6,15 @@
 /*
  * Move Generation
  *
- * Generates pseudo-legal moves into the global move buffer.
- * Legality is checked later in board_make_move (king not left in check).
+ * Generates pseudo-legal moves into the global move buffer; legality is
+ * then checked by board_make_move (king not left in check). The _legal
+ * variants instead drop illegal moves up front using checkers and pins
+ * computed once per node, so their moves can be played with
+ * board_make_legal_move.
  *
  * Uses a flat buffer with ply-based indexing to avoid dynamic allocation.
+ * Pieces are found through g_state.piece_list (0x88 build) or the
+ * bitboards (PC build) rather than board scans.
  */
 
 /* Generate all pseudo-legal moves for the current position.
@@ -21,7 +26,35 @@ u16 movegen_generate(u8 ply);
  * Returns the number of moves generated. */
 u16 movegen_generate_captures(u8 ply);
 
-/* Check if the current side has any legal moves (for mate/stalemate detection) */
+/* Legal-only versions of the above (same move order, illegal moves
+ * removed). Returns the number of legal moves. */
+u16 movegen_generate_legal(u8 ply);
+u16 movegen_generate_legal_captures(u8 ply);
+
+/* Append the legal quiet moves (non-captures, push-promotions, castling)
+ * after the first count moves of this ply, e.g. after the legal captures.
+ * Returns the new total. */
+u16 movegen_append_legal_quiets(u8 ply, u16 count);
+
+/* Is m (e.g. a TT move or killer) a legal move in this position?
+ * board_is_pseudo_legal plus a pin test; nothing is generated. */
+u8 movegen_is_legal(Move m);
+
+/* Legal moves out of check only: king steps, captures of a single
+ * checker and interpositions on its ray (king steps alone in double
+ * check). The side to move must be in check. */
+u16 movegen_generate_evasions(u8 ply);
+
+/* Legal non-capture, non-promotion moves that give check (for the first
+ * quiescence ply). Returns the number of moves generated. */
+u16 movegen_generate_quiet_checks(u8 ply);
+
+/* Check if the current side has any legal moves (for mate/stalemate
+ * detection). Tries king steps first and stops at the first legal move. */
 u8 movegen_has_legal_move(void);
 
+/* Number of legal moves (promotions count four). Neither function writes
+ * to move_buf, so both are safe to call during a search. */
+u16 movegen_count_legal(void);
+
 #endif /* MOVEGEN_H */
@@ -0,0 +1,160 @@
+/*
+ * Color template for movegen.c - included once with SIDE defined as WHITE
+ * and once as BLACK (no include guard). Each pass instantiates
+ * generate_pawns_<color>, which generates the moves of all our pawns with
+ * the push direction, capture offsets, start and promotion ranks fixed at
+ * compile time. generate_all dispatches on the color once per node.
+ *
+ * Expects add_move, add_promotions and the GEN_* modes of movegen.c.
+ */
+
+#if SIDE == WHITE
+#define US            WHITE
+#define THEM          BLACK
+#define THEM_COLOR    COLOR_MASK
+#define PAWN_UP       16      /* push step on the 0x88 board ... */
+#define PAWN_UP64     8       /* ... and in 0..63 square indices */
+#define START_RANK    1
+#define PROMO_RANK    7
+#define SIDE_FN(name) name##_white
+#else
+#define US            BLACK
+#define THEM          WHITE
+#define THEM_COLOR    0
+#define PAWN_UP       (-16)
+#define PAWN_UP64     (-8)
+#define START_RANK    6
+#define PROMO_RANK    0
+#define SIDE_FN(name) name##_black
+#endif
+
+#ifndef USE_BITBOARDS
+
+/* Pawn moves of US on the 0x88 board: per pawn, captures (left, right),
+ * en passant, then pushes */
+static u16 SIDE_FN(generate_pawns)(u8 ply, u16 count, u8 gen) {
+    const u8 *list = g_state.piece_list[US][PAWN];
+    u8 n, sq, target, piece;
+
+    for (n = 0; n < g_state.piece_count[US][PAWN]; n++) {
+        sq = list[n];
+
+        if (gen & GEN_CAPTURES) {
+            target = (u8)(sq + PAWN_UP - 1);
+            if (SQ_VALID(target)) {
+                piece = g_state.board[target];
+                if (piece != EMPTY && (piece & COLOR_MASK) == THEM_COLOR) {
+                    if (SQ_RANK(target) == PROMO_RANK) {
+                        count = add_promotions(ply, count, sq, target, 1);
+                    } else {
+                        count = add_move(ply, count, sq, target, MF_CAPTURE);
+                    }
+                }
+            }
+
+            target = (u8)(sq + PAWN_UP + 1);
+            if (SQ_VALID(target)) {
+                piece = g_state.board[target];
+                if (piece != EMPTY && (piece & COLOR_MASK) == THEM_COLOR) {
+                    if (SQ_RANK(target) == PROMO_RANK) {
+                        count = add_promotions(ply, count, sq, target, 1);
+                    } else {
+                        count = add_move(ply, count, sq, target, MF_CAPTURE);
+                    }
+                }
+            }
+
+            /* En passant */
+            if (g_state.ep_square != SQ_NONE) {
+                if ((u8)(sq + PAWN_UP - 1) == g_state.ep_square ||
+                    (u8)(sq + PAWN_UP + 1) == g_state.ep_square) {
+                    count = add_move(ply, count, sq, g_state.ep_square,
+                                     (u8)(MF_CAPTURE | MF_EP));
+                }
+            }
+        }
+
+        if (!(gen & GEN_QUIETS)) continue;
+
+        /* Forward one square, then two from the starting rank */
+        target = (u8)(sq + PAWN_UP);
+        if (g_state.board[target] == EMPTY) {
+            if (SQ_RANK(target) == PROMO_RANK) {
+                count = add_promotions(ply, count, sq, target, 0);
+            } else {
+                count = add_move(ply, count, sq, target, MF_NONE);
+                if (SQ_RANK(sq) == START_RANK &&
+                    g_state.board[(u8)(target + PAWN_UP)] == EMPTY) {
+                    count = add_move(ply, count, sq, (u8)(target + PAWN_UP),
+                                     MF_PAWNSTART);
+                }
+            }
+        }
+    }
+    return count;
+}
+
+#else /* USE_BITBOARDS */
+
+/* Pawn moves of US from the bitboards, in the same per-pawn order */
+static u16 SIDE_FN(generate_pawns)(u8 ply, u16 count, u8 gen) {
+    Bitboard pawns = g_state.bb_pieces[US][PAWN];
+    Bitboard them = g_state.bb_color[THEM];
+    Bitboard empty = ~g_state.bb_occupied;
+    Bitboard ep = (g_state.ep_square != SQ_NONE) ?
+                  BB_SQ(SQ_INDEX64(g_state.ep_square)) : 0;
+    Bitboard caps;
+    u8 from64, to64, from;
+
+    while (pawns) {
+        from64 = bb_pop_lsb(&pawns);
+        from = (u8)SQ_FROM64(from64);
+
+        if (gen & GEN_CAPTURES) {
+            caps = bb_pawn_attacks[US][from64] & them;
+            while (caps) {
+                to64 = bb_pop_lsb(&caps);
+                if (SQ_RANK(SQ_FROM64(to64)) == PROMO_RANK) {
+                    count = add_promotions(ply, count, from, (u8)SQ_FROM64(to64), 1);
+                } else {
+                    count = add_move(ply, count, from, (u8)SQ_FROM64(to64), MF_CAPTURE);
+                }
+            }
+
+            /* En passant */
+            if (bb_pawn_attacks[US][from64] & ep) {
+                count = add_move(ply, count, from, g_state.ep_square,
+                                 (u8)(MF_CAPTURE | MF_EP));
+            }
+        }
+
+        if (!(gen & GEN_QUIETS)) continue;
+
+        /* Forward one square, then two from the starting rank */
+        to64 = (u8)(from64 + PAWN_UP64);
+        if (empty & BB_SQ(to64)) {
+            if (SQ_RANK((u8)(from + PAWN_UP)) == PROMO_RANK) {
+                count = add_promotions(ply, count, from, (u8)SQ_FROM64(to64), 0);
+            } else {
+                count = add_move(ply, count, from, (u8)SQ_FROM64(to64), MF_NONE);
+                if (SQ_RANK(from) == START_RANK &&
+                    (empty & BB_SQ(to64 + PAWN_UP64))) {
+                    count = add_move(ply, count, from,
+                                     (u8)SQ_FROM64(to64 + PAWN_UP64), MF_PAWNSTART);
+                }
+            }
+        }
+    }
+    return count;
+}
+
+#endif /* USE_BITBOARDS */
+
+#undef US
+#undef THEM
+#undef THEM_COLOR
+#undef PAWN_UP
+#undef PAWN_UP64
+#undef START_RANK
+#undef PROMO_RANK
+#undef SIDE_FN
@@ -1,106 +1,406 @@
 #include "movesort.h"
 #include "tables.h"
+#include "movegen.h"
+#include "see.h"
 
-/* Killer moves: 2 per ply */
-static Move killers[MAX_PLY][2];
+#ifndef TARGET_C64
+#include <string.h>
+#include "engine.h"
+#endif
+
+/* Killer moves of the current engine: 2 per ply */
+#define killers (g_engine->killers)
+
+/* Ordering scores: captures, promotions, killers and the countermove
+ * rank above any sum of history scores (3 x HISTORY_MAX) */
+#define SCORE_CAPTURE   30000     /* + MVV-LVA */
+#define SCORE_PROMO     29000     /* + promoted type */
+#define SCORE_KILLER1   28000
+#define SCORE_KILLER2   27900
+#define SCORE_COUNTER   27000
+
+#ifndef TARGET_C64
+#define history        (g_engine->history)
+#define countermoves   (g_engine->countermoves)
+#define cont_history   (g_engine->cont_history)
+#define played         (g_engine->played)
+
+/* History entries stay within +-HISTORY_MAX */
+#define HISTORY_MAX     8192
+
+/* Largest bonus of a cutoff, reached from depth 8 on */
+#define HISTORY_BONUS_MAX 1200
+
+/* Piece-to key of m in the current position (before it is made) */
+static u16 piece_to(Move m) {
+    u8 piece = g_state.board[MOVE_FROM(m)];
+    u16 kind = (u16)((IS_BLACK(piece) ? 6 : 0) + PIECE_TYPE(piece) - 1);
+    return (u16)(kind * 64 + SQ_INDEX64(MOVE_TO(m)));
+}
+
+/* Piece-to key of the move made n plies above ply, or PIECE_TO_NONE */
+static u16 played_before(u8 ply, u8 n) {
+    if (ply < n || ply - n >= MAX_PLY) return PIECE_TO_NONE;
+    return played[ply - n];
+}
+#endif
 
 void movesort_clear_killers(void) {
     u8 i;
     for (i = 0; i < MAX_PLY; i++) {
-        killers[i][0].from = 0;
-        killers[i][0].to = 0;
-        killers[i][0].flags = 0;
-        killers[i][0].score = 0;
-        killers[i][1].from = 0;
-        killers[i][1].to = 0;
-        killers[i][1].flags = 0;
-        killers[i][1].score = 0;
+        killers[i][0] = MOVE_NONE;
+        killers[i][1] = MOVE_NONE;
     }
 }
 
-static u8 moves_equal(Move a, Move b) {
-    return (a.from == b.from && a.to == b.to && a.flags == b.flags);
-}
-
-void movesort_score_moves(u8 ply, u16 num_moves, Move *pv_move) {
-    u16 base = g_state.move_buf_idx[ply];
-    u16 i;
-
-    for (i = 0; i < num_moves; i++) {
-        Move *m = &g_state.move_buf[base + i];
+/* Ordering score of a generated move */
+static s16 score_move(u8 ply, Move m) {
+    u8 flags = MOVE_FLAGS(m);
 
-        /* PV move gets highest score */
-        if (pv_move && m->from == pv_move->from &&
-            m->to == pv_move->to && m->flags == pv_move->flags) {
-            m->score = 255;
-            continue;
+    /* Captures: scored by MVV-LVA */
+    if (flags & MF_CAPTURE) {
+        u8 victim, attacker;
+        if (flags & MF_EP) {
+            victim = PAWN;
+        } else {
+            victim = PIECE_TYPE(g_state.board[MOVE_TO(m)]);
         }
+        attacker = PIECE_TYPE(g_state.board[MOVE_FROM(m)]);
+        return SCORE_CAPTURE + mvv_lva[victim][attacker];
+    }
 
-        /* Captures: scored by MVV-LVA */
-        if (m->flags & MF_CAPTURE) {
-            u8 victim, attacker;
-            if (m->flags & MF_EP) {
-                victim = PAWN;
-            } else {
-                victim = PIECE_TYPE(g_state.board[m->to]);
-            }
-            attacker = PIECE_TYPE(g_state.board[m->from]);
-            m->score = 200 + mvv_lva[victim][attacker];
-            continue;
-        }
+    /* Promotions (non-capture) */
+    if (flags & MF_PROMO) {
+        return SCORE_PROMO + PROMO_TYPE(flags);
+    }
 
-        /* Promotions (non-capture) */
-        if (m->flags & MF_PROMO) {
-            m->score = 190 + PROMO_TYPE(m->flags);
-            continue;
-        }
+    /* Killer moves (only seen here among evasions; the main search hands
+     * them out in their own stages) */
+    if (ply < MAX_PLY) {
+        if (m == killers[ply][0]) return SCORE_KILLER1;
+        if (m == killers[ply][1]) return SCORE_KILLER2;
+    }
 
-        /* Killer moves */
-        if (ply < MAX_PLY) {
-            if (moves_equal(*m, killers[ply][0])) {
-                m->score = 150;
-                continue;
-            }
-            if (moves_equal(*m, killers[ply][1])) {
-                m->score = 140;
-                continue;
-            }
+#ifndef TARGET_C64
+    /* Quiet moves: the countermove to the previous move first, then by
+     * butterfly history plus the continuation history of the moves one
+     * and two plies back */
+    {
+        u16 prev1 = played_before(ply, 1);
+        u16 prev2 = played_before(ply, 2);
+        u16 pt = piece_to(m);
+        s16 score = history[g_state.side][SQ_INDEX64(MOVE_FROM(m))]
+                           [SQ_INDEX64(MOVE_TO(m))];
+
+        if (prev1 != PIECE_TO_NONE) {
+            if (countermoves[prev1] == m) return SCORE_COUNTER;
+            score += cont_history[prev1][pt];
         }
+        if (prev2 != PIECE_TO_NONE) score += cont_history[prev2][pt];
+        return score;
+    }
+#else
+    /* Quiet moves */
+    return 0;
+#endif
+}
 
-        /* Quiet moves */
-        m->score = 0;
+static void score_range(MovePicker *mp, u16 from, u16 to) {
+    u16 base = g_state.move_buf_idx[mp->ply];
+    u16 i;
+    for (i = base + from; i < base + to; i++) {
+        g_state.move_score[i] = score_move(mp->ply, g_state.move_buf[i]);
     }
 }
 
-void movesort_pick_best(u8 ply, u16 idx, u16 num_moves) {
-    u16 base = g_state.move_buf_idx[ply];
-    u16 best_i = idx;
-    u8 best_score = g_state.move_buf[base + idx].score;
+/* Selection sort step: swap the best remaining move to idx, return it.
+ * Only the scores are scanned; moves are touched for the swap alone. */
+static Move pick_best(MovePicker *mp) {
+    u16 base = g_state.move_buf_idx[mp->ply];
+    Move *moves = &g_state.move_buf[base];
+    s16 *scores = &g_state.move_score[base];
+    u16 best_i = mp->idx;
+    s16 best_score = scores[mp->idx];
     u16 i;
     Move tmp;
 
-    for (i = idx + 1; i < num_moves; i++) {
-        if (g_state.move_buf[base + i].score > best_score) {
-            best_score = g_state.move_buf[base + i].score;
+    for (i = mp->idx + 1; i < mp->end; i++) {
+        if (scores[i] > best_score) {
+            best_score = scores[i];
             best_i = i;
         }
     }
 
-    if (best_i != idx) {
-        tmp = g_state.move_buf[base + idx];
-        g_state.move_buf[base + idx] = g_state.move_buf[base + best_i];
-        g_state.move_buf[base + best_i] = tmp;
+    tmp = moves[best_i];
+    if (best_i != mp->idx) {
+        moves[best_i] = moves[mp->idx];
+        moves[mp->idx] = tmp;
+        scores[best_i] = scores[mp->idx];
+        scores[mp->idx] = best_score;
+    }
+    mp->idx++;
+    return tmp;
+}
+
+void movepicker_init(MovePicker *mp, u8 ply, const Move *tt_move, u8 in_check) {
+    mp->ply = ply;
+    mp->qsearch = 0;
+    mp->with_checks = 0;
+    mp->idx = 0;
+    mp->end = 0;
+    mp->bad_idx = 0;
+    mp->bad_end = 0;
+    mp->tt_move = MOVE_NONE;
+    mp->killer[0] = MOVE_NONE;
+    mp->killer[1] = MOVE_NONE;
+
+    /* Nothing generated yet: children start right at this ply's slot */
+    g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply];
+
+    /* The TT move comes from a lossy table; it is only kept if legal here */
+    if (tt_move && !IS_MOVE_NONE(*tt_move) && movegen_is_legal(*tt_move)) {
+        mp->tt_move = *tt_move;
+    }
+    mp->stage = MP_TT;
+    mp->in_check = in_check;
+}
+
+void movepicker_init_qsearch(MovePicker *mp, u8 ply, u8 with_checks) {
+    mp->ply = ply;
+    mp->stage = MP_GEN_CAPTURES;
+    mp->in_check = 0;
+    mp->qsearch = 1;
+    mp->with_checks = with_checks;
+    mp->idx = 0;
+    mp->end = 0;
+    mp->bad_idx = 0;
+    mp->bad_end = 0;
+    mp->tt_move = MOVE_NONE;
+    mp->killer[0] = MOVE_NONE;
+    mp->killer[1] = MOVE_NONE;
+}
+
+/* Was m already handed out as the TT move or a killer? Generated moves
+ * are never MOVE_NONE, so unset slots never match. */
+static u8 already_tried(const MovePicker *mp, Move m) {
+    return m == mp->tt_move || m == mp->killer[0] || m == mp->killer[1];
+}
+
+/* The capture just picked (at idx - 1) loses material: park it at the
+ * front of the slot, over captures already handed out. They stay in
+ * MVV-LVA order for the MP_BAD_CAPTURES stage. */
+static void keep_bad_capture(MovePicker *mp) {
+    u16 base = g_state.move_buf_idx[mp->ply];
+    Move tmp = g_state.move_buf[base + mp->idx - 1];
+    g_state.move_buf[base + mp->idx - 1] = g_state.move_buf[base + mp->bad_end];
+    g_state.move_buf[base + mp->bad_end] = tmp;
+    mp->bad_end++;
+}
+
+/* Hand out killer n of this ply if it is a legal quiet move here */
+static u8 try_killer(MovePicker *mp, u8 n, Move *m) {
+    Move k;
+
+    if (mp->ply >= MAX_PLY) return 0;
+    k = killers[mp->ply][n];
+    if (IS_MOVE_NONE(k) || k == mp->tt_move) return 0;
+    if (MOVE_FLAGS(k) & MF_CAPTURE) return 0;
+    if (!movegen_is_legal(k)) return 0;
+    mp->killer[n] = k;
+    *m = k;
+    return 1;
+}
+
+u8 movepicker_next(MovePicker *mp, Move *m) {
+    u8 ply = mp->ply;
+
+    for (;;) {
+        switch (mp->stage) {
+            case MP_TT:
+                mp->stage = mp->in_check ? MP_GEN_EVASIONS : MP_GEN_CAPTURES;
+                if (!IS_MOVE_NONE(mp->tt_move)) {
+                    *m = mp->tt_move;
+                    return 1;
+                }
+                break;
+
+            case MP_GEN_CAPTURES:
+                mp->end = movegen_generate_legal_captures(ply);
+                score_range(mp, 0, mp->end);
+                mp->stage = MP_CAPTURES;
+                break;
+
+            case MP_CAPTURES:
+                while (mp->idx < mp->end) {
+                    *m = pick_best(mp);
+                    if (*m == mp->tt_move) continue;
+                    if (see_ge(*m, 0)) return 1;
+                    /* Losing: quiescence drops it, the main search keeps
+                     * it for after the killers */
+                    if (!mp->qsearch) keep_bad_capture(mp);
+                }
+                if (mp->qsearch) {
+                    mp->stage = mp->with_checks ? MP_GEN_CHECKS : MP_DONE;
+                } else {
+                    mp->stage = MP_KILLER1;
+                }
+                break;
+
+            case MP_KILLER1:
+                mp->stage = MP_KILLER2;
+                if (try_killer(mp, 0, m)) return 1;
+                break;
+
+            case MP_KILLER2:
+                mp->stage = MP_BAD_CAPTURES;
+                if (try_killer(mp, 1, m)) return 1;
+                break;
+
+            case MP_BAD_CAPTURES:
+                if (mp->bad_idx < mp->bad_end) {
+                    *m = g_state.move_buf[g_state.move_buf_idx[ply] + mp->bad_idx];
+                    mp->bad_idx++;
+                    return 1;
+                }
+                mp->stage = MP_GEN_QUIETS;
+                break;
+
+            case MP_GEN_QUIETS:
+                mp->end = movegen_append_legal_quiets(ply, mp->end);
+                score_range(mp, mp->idx, mp->end);
+                mp->stage = MP_QUIETS;
+                break;
+
+            case MP_QUIETS:
+                while (mp->idx < mp->end) {
+                    *m = pick_best(mp);
+                    if (!already_tried(mp, *m)) return 1;
+                }
+                mp->stage = MP_DONE;
+                break;
+
+            case MP_GEN_EVASIONS:
+                mp->end = movegen_generate_evasions(ply);
+                score_range(mp, 0, mp->end);
+                mp->stage = MP_EVASIONS;
+                break;
+
+            case MP_EVASIONS:
+                while (mp->idx < mp->end) {
+                    *m = pick_best(mp);
+                    if (*m != mp->tt_move) return 1;
+                }
+                mp->stage = MP_DONE;
+                break;
+
+            case MP_GEN_CHECKS:
+                mp->idx = 0;
+                mp->end = movegen_generate_quiet_checks(ply);
+                mp->stage = MP_CHECKS;
+                break;
+
+            case MP_CHECKS:
+                if (mp->idx < mp->end) {
+                    *m = g_state.move_buf[g_state.move_buf_idx[ply] + mp->idx];
+                    mp->idx++;
+                    return 1;
+                }
+                mp->stage = MP_DONE;
+                break;
+
+            default:
+                return 0;
+        }
     }
 }
 
 void movesort_update_killers(u8 ply, Move m) {
     if (ply >= MAX_PLY) return;
     /* Don't store captures as killers */
-    if (m.flags & MF_CAPTURE) return;
+    if (MOVE_FLAGS(m) & MF_CAPTURE) return;
 
     /* Shift killer[0] to killer[1], store new in killer[0] */
-    if (!moves_equal(m, killers[ply][0])) {
+    if (m != killers[ply][0]) {
         killers[ply][1] = killers[ply][0];
         killers[ply][0] = m;
     }
 }
+
+#ifndef TARGET_C64
+void movesort_set_played(u8 ply, Move m) {
+    if (ply >= MAX_PLY) return;
+    played[ply] = IS_MOVE_NONE(m) ? PIECE_TO_NONE : piece_to(m);
+}
+
+/* Gravity update: entries move toward +-HISTORY_MAX by less the closer
+ * they already are, so they stay bounded and old results fade */
+static void history_add(s16 *entry, s16 bonus) {
+    s32 e = *entry;
+    s32 b = bonus;
+    e += b - e * (b < 0 ? -b : b) / HISTORY_MAX;
+    *entry = (s16)e;
+}
+
+/* Reward (bonus > 0) or penalize one quiet move in all three tables */
+static void update_quiet(u8 ply, Move m, s16 bonus) {
+    u16 prev1 = played_before(ply, 1);
+    u16 prev2 = played_before(ply, 2);
+    u16 pt = piece_to(m);
+
+    history_add(&history[g_state.side][SQ_INDEX64(MOVE_FROM(m))]
+                        [SQ_INDEX64(MOVE_TO(m))], bonus);
+    if (prev1 != PIECE_TO_NONE) history_add(&cont_history[prev1][pt], bonus);
+    if (prev2 != PIECE_TO_NONE) history_add(&cont_history[prev2][pt], bonus);
+}
+
+s16 movesort_history_bonus(u8 depth) {
+    s32 bonus = 16 * (s32)depth * depth + 32 * (s32)depth;
+    return (s16)(bonus > HISTORY_BONUS_MAX ? HISTORY_BONUS_MAX : bonus);
+}
+
+void movesort_update_quiet_stats(u8 ply, Move best, const Move *tried,
+                                 u8 tried_count, u8 depth) {
+    s16 bonus;
+    u16 prev1;
+    u8 i;
+
+    if (MOVE_FLAGS(best) & (MF_CAPTURE | MF_PROMO)) return;
+
+    bonus = movesort_history_bonus(depth);
+    update_quiet(ply, best, bonus);
+    for (i = 0; i < tried_count; i++) {
+        update_quiet(ply, tried[i], (s16)-bonus);
+    }
+
+    prev1 = played_before(ply, 1);
+    if (prev1 != PIECE_TO_NONE) countermoves[prev1] = best;
+}
+
+void movesort_age_history(void) {
+    s16 *p;
+    u32 i;
+
+    p = &history[0][0][0];
+    for (i = 0; i < 2 * 64 * 64; i++) p[i] /= 2;
+    p = &cont_history[0][0];
+    for (i = 0; i < (u32)PIECE_TO_COUNT * PIECE_TO_COUNT; i++) p[i] /= 2;
+}
+
+static void clear_history_tables(void) {
+    memset(history, 0, sizeof(history));
+    memset(countermoves, 0, sizeof(countermoves));
+    memset(cont_history, 0, sizeof(cont_history));
+}
+
+void movesort_clear_history(void) {
+    Engine *self = g_engine;
+    u8 i;
+
+    clear_history_tables();
+    for (i = 0; i < self->helper_count; i++) {
+        engine_set_current(self->helpers[i]);
+        clear_history_tables();
+    }
+    engine_set_current(self);
+}
+#endif
@@ -5,16 +5,61 @@
 
 /*
  * Move Ordering
- * Assigns scores to moves for alpha-beta search efficiency.
- * Order: PV move > Captures (MVV-LVA) > Killers > Quiet moves
+ * A staged move picker hands out one ply's legal moves, best first:
+ * TT move > Winning/even captures (MVV-LVA) > Killers > Losing captures >
+ * Quiet moves.
+ * Each stage is generated only when the previous one is used up, so a
+ * node that cuts off on the TT move, a capture or a killer never
+ * generates quiets. The TT move and killers are checked with
+ * movegen_is_legal before they are handed out. Captures that lose
+ * material by static exchange (see_ge) are held back until after the
+ * killers, and dropped altogether in quiescence.
+ * On PC, quiets are ordered by what happened to them elsewhere in the
+ * tree: the countermove to the previous move first, then butterfly
+ * history [side][from][to] plus continuation history, keyed by the piece
+ * and target of the moves one and two plies back. The C64 has no room for
+ * these tables and leaves quiets in generation order.
  */
 
-/* Score all moves at a given ply for ordering */
-void movesort_score_moves(u8 ply, u16 num_moves, Move *pv_move);
+/* Picker stages */
+#define MP_TT           0
+#define MP_GEN_CAPTURES 1
+#define MP_CAPTURES     2
+#define MP_KILLER1      3
+#define MP_KILLER2      4
+#define MP_BAD_CAPTURES 5
+#define MP_GEN_QUIETS   6
+#define MP_QUIETS       7
+#define MP_GEN_EVASIONS 8
+#define MP_EVASIONS     9
+#define MP_GEN_CHECKS   10
+#define MP_CHECKS       11
+#define MP_DONE         12
 
-/* Pick the best-scored move from position idx onward (selection sort step).
- * Swaps it into position idx. */
-void movesort_pick_best(u8 ply, u16 idx, u16 num_moves);
+typedef struct {
+    u8   ply;
+    u8   stage;
+    u8   in_check;      /* evasions replace captures/killers/quiets */
+    u8   qsearch;       /* captures (and optionally checks) only */
+    u8   with_checks;   /* qsearch: quiet checks after the captures */
+    Move tt_move;       /* MOVE_NONE if none */
+    Move killer[2];     /* killers already handed out (MOVE_NONE if not) */
+    u16  idx;           /* next move in this ply's buffer slot */
+    u16  end;           /* number of moves generated so far */
+    u16  bad_idx;       /* next losing capture to hand out */
+    u16  bad_end;       /* losing captures, kept at the slot's start */
+} MovePicker;
+
+/* Start picking moves for the main search. tt_move may be NULL; it is
+ * validated before being played. in_check selects the evasion stage. */
+void movepicker_init(MovePicker *mp, u8 ply, const Move *tt_move, u8 in_check);
+
+/* Start picking moves for quiescence: captures, then quiet checks if
+ * with_checks. Call movepicker_init instead when in check. */
+void movepicker_init_qsearch(MovePicker *mp, u8 ply, u8 with_checks);
+
+/* Next legal move, or 0 when there are none left */
+u8 movepicker_next(MovePicker *mp, Move *m);
 
 /* Update killer move table after a beta cutoff */
 void movesort_update_killers(u8 ply, Move m);
@@ -22,4 +67,27 @@ void movesort_update_killers(u8 ply, Move m);
 /* Clear killer move table */
 void movesort_clear_killers(void);
 
+#ifndef TARGET_C64
+/* Note the move about to be made at ply (MOVE_NONE for a null move), as
+ * context for ordering the plies below. Call before making it. */
+void movesort_set_played(u8 ply, Move m);
+
+/* After best caused a beta cutoff at ply: if it is quiet, reward it in the
+ * history tables and make it the countermove, and penalize the tried
+ * quiets that were searched before it without a cutoff */
+void movesort_update_quiet_stats(u8 ply, Move best, const Move *tried,
+                                 u8 tried_count, u8 depth);
+
+/* History bonus (and malus) of a cutoff at depth: 16 d^2 + 32 d, capped
+ * at 1200, so it never shrinks as the depth grows */
+s16 movesort_history_bonus(u8 depth);
+
+/* Halve the history tables, so a new search leans on its own results */
+void movesort_age_history(void);
+
+/* Forget all history and countermoves of the current engine and its
+ * Lazy SMP helpers (new game) */
+void movesort_clear_history(void);
+#endif
+
 #endif /* MOVESORT_H */
@@ -10,6 +10,8 @@
 #include <c64.h>
 #else
 #include <stdio.h>
+#include <string.h>
+#include "engine.h"
 #endif
 
 #ifndef TARGET_C64
@@ -21,14 +23,65 @@ extern FILE *dbg_file;
 #include <windows.h>
 #else
 #include <sys/time.h>
+#include <pthread.h>
 #endif
 #endif
 
-SearchInfo g_search_info;
+/* Triangular PV table of the current engine */
+#define pv_table  (g_engine->pv_table)
+#define pv_length (g_engine->pv_length)
+
+/* Static forward pruning: the current engine's enabled techniques
+ * (PRUNE_*; it stores those switched off, so a zeroed engine has all of
+ * them), and their margins by remaining depth. None is tried deeper than
+ * its table. */
+#define pruning ((u8)(PRUNE_ALL & ~g_engine->pruning_off))
+
+#define RFP_DEPTH      6
+#define RAZOR_DEPTH    3
+#define FUTILITY_DEPTH 3
+#define LMP_DEPTH      4
+static const s16 rfp_margin[RFP_DEPTH + 1] = { 0, 100, 180, 260, 340, 420, 500 };
+static const s16 razor_margin[RAZOR_DEPTH + 1] = { 0, 300, 400, 550 };
+static const s16 futility_margin[FUTILITY_DEPTH + 1] = { 0, 150, 300, 450 };
+/* Late move pruning: moves searched before the quiet ones are skipped,
+ * [improving][depth] */
+static const u8 lmp_count[2][LMP_DEPTH + 1] = {
+    { 0, 3, 5, 8, 12 },
+    { 0, 5, 8, 13, 20 }
+};
+
+/* Static eval of the current engine by ply; EVAL_NONE in check */
+#define eval_stack (g_engine->eval_stack)
+#define EVAL_NONE  (-SCORE_INFINITY)
+
+/* Move left out at each ply by a singular extension search */
+#define excluded_moves (g_engine->excluded)
+
+/* Internal iterative reduction: nodes this deep without a TT move are
+ * searched one ply shallower */
+#define IIR_DEPTH 4
+
+/* Singular extensions: from SE_DEPTH, a TT move with a lower bound from
+ * at most 3 plies shallower is extended if no other move comes within
+ * SE_MARGIN per ply of that bound, in a search of half the depth */
+#define SE_DEPTH  6
+#define SE_MARGIN 2
 
-/* Triangular PV table */
-static Move pv_table[MAX_PLY][MAX_PLY];
-static u8 pv_length[MAX_PLY];
+#ifndef TARGET_C64
+/* Lazy SMP: the current engine's helpers (Engine.helpers) search its root
+ * on their own threads, sharing its TT, until the main search ends and
+ * raises each helper's smp_stop */
+#define helper_count (g_engine->helper_count)
+#define helpers      (g_engine->helpers)
+
+/* Depth skipping of helper n: it leaves out depth d when
+ * ((d + skip_phase[i]) / skip_size[i]) is odd, i = (n - 1) % 20 */
+static const u8 skip_size[20]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                   3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const u8 skip_phase[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                   4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+#endif
 
 /* --- Platform-specific timing --- */
 
@@ -50,12 +103,27 @@ u32 get_time_ms(void) {
 #endif
 }
 
-void search_check_time(void) {
-    if (!g_search_info.use_time) return;
+void search_set_pruning(u8 mask) {
+    g_engine->pruning_off = (u8)(PRUNE_ALL & ~mask);
+}
 
+u8 search_get_pruning(void) {
+    return pruning;
+}
+
+void search_check_time(void) {
     /* Only check every 1024 nodes to reduce overhead */
     if ((g_search_info.nodes & 1023) != 0) return;
 
+#ifndef TARGET_C64
+    /* Helpers stop when the main search is done */
+    if (g_engine->smp_stop) {
+        g_search_info.stopped = 1;
+        return;
+    }
+#endif
+    if (!g_search_info.use_time) return;
+
     if (get_time_ms() - g_search_info.start_time >= g_search_info.max_time_ms) {
         g_search_info.stopped = 1;
     }
@@ -63,37 +131,41 @@ void search_check_time(void) {
 
 /* --- Quiescence Search --- */
 
-static s16 quiescence(s16 alpha, s16 beta, u8 ply) {
-    s16 stand_pat;
-    u16 num_moves, i, base_idx;
+/* qply counts plies from the start of quiescence: quiet checks are only
+ * tried at qply 0, and a side in check searches all its evasions */
+static s16 quiescence(s16 alpha, s16 beta, u8 ply, u8 qply) {
+    MovePicker mp;
+    Move m;
+    s16 score;
+    u8 in_check;
 
     if (g_search_info.stopped) return 0;
     if (ply >= MAX_PLY - 2) return eval_position();
     g_search_info.nodes++;
 
-    /* Stand-pat: use static eval as lower bound */
-    stand_pat = eval_position();
-    if (stand_pat >= beta) return beta;
-    if (stand_pat > alpha) alpha = stand_pat;
-
-    /* Generate capture moves only */
-    num_moves = movegen_generate_captures(ply);
-    if (num_moves == 0) return alpha;
-
-    /* Score and sort captures */
-    movesort_score_moves(ply, num_moves, NULL);
-    base_idx = g_state.move_buf_idx[ply];
-
-    for (i = 0; i < num_moves; i++) {
-        s16 score;
-        Move saved_move;
-        movesort_pick_best(ply, i, num_moves);
-
-        saved_move = g_state.move_buf[base_idx + i];
-        if (!board_make_move(saved_move)) continue;
+    in_check = board_in_check();
+    if (in_check) {
+        /* In check there is no stand-pat: every evasion is searched */
+        movepicker_init(&mp, ply, NULL, 1);
+    } else {
+        /* Stand-pat: use static eval as lower bound */
+        s16 stand_pat = eval_position();
+        if (stand_pat >= beta) return beta;
+        if (stand_pat > alpha) alpha = stand_pat;
+
+        /* Captures, then at the first qsearch ply quiet checks, so mating
+         * attacks at the horizon are not cut off by stand-pat */
+        movepicker_init_qsearch(&mp, ply, qply == 0);
+    }
 
-        score = -quiescence(-beta, -alpha, ply + 1);
-        board_unmake_move(saved_move);
+    while (movepicker_next(&mp, &m)) {
+#ifndef TARGET_C64
+        movesort_set_played(ply, m);
+#endif
+        board_make_legal_move(m);
+        score = -quiescence(-beta, -alpha, ply + 1, qply + 1);
+        board_unmake_move(m);
+        in_check = 0; /* a move was found: not mate */
 
         if (g_search_info.stopped) return 0;
         if (score > alpha) {
@@ -102,13 +174,27 @@ static s16 quiescence(s16 alpha, s16 beta, u8 ply) {
         }
     }
 
+    if (in_check) return -SCORE_MATE + ply; /* checkmate */
     return alpha;
 }
 
+#ifndef TARGET_C64
+/* Is m one of the root moves to search? */
+static u8 is_root_move(Move m) {
+    u16 i;
+    if (g_search_info.root_move_count == 0) return 1;
+    for (i = 0; i < g_search_info.root_move_count; i++) {
+        if (g_search_info.root_moves[i] == m) return 1;
+    }
+    return 0;
+}
+#endif
+
 /* --- Negamax with Alpha-Beta --- */
 
 static s16 negamax(s16 alpha, s16 beta, u8 depth, u8 ply, u8 do_null) {
-    u16 num_moves, i, base_idx;
+    MovePicker mp;
+    Move saved_move;
     u16 legal_moves = 0;
     s16 best_score = -SCORE_INFINITY;
     Move best_move;
@@ -116,45 +202,70 @@ static s16 negamax(s16 alpha, s16 beta, u8 depth, u8 ply, u8 do_null) {
     u8 tt_flag = TT_FLAG_ALPHA;
     u8 in_check;
     u8 has_pv = 0;
+    u8 pv_node = (beta > alpha + 1);
+    u8 improving;
+    u8 futile = 0;
+    u8 late_prune = 0;
+    u8 quiet, gives_check;
     s16 score;
+    s16 static_eval;
+    TTHit tt_hit;
+    u8 tt_found;
+    u8 extension = 0;       /* for the TT move, if singular */
+    Move excluded = excluded_moves[ply];
+    u8 store_tt = IS_MOVE_NONE(excluded);
+#ifndef TARGET_C64
+    Move quiets[64];    /* quiets searched without a cutoff */
+    u8 quiet_count = 0;
+#endif
 
-    best_move.from = 0;
-    best_move.to = 0;
-    best_move.flags = 0;
-    best_move.score = 0;
+    best_move = MOVE_NONE;
 
     pv_length[ply] = ply;
 
+#ifndef TARGET_C64
+    /* A root limited to searchmoves scores only those moves, not the
+     * position: keep it out of the TT (like a search excluding a move) */
+    if (ply == 0 && g_search_info.root_move_count) store_tt = 0;
+#endif
+
     if (g_search_info.stopped) return 0;
 
     /* Ply limit to prevent stack overflow */
     if (ply >= MAX_PLY - 2) return eval_position();
 
     /* Check for draw by repetition or fifty-move rule */
-    if (ply > 0 && (board_is_repetition() || g_state.fifty_clock >= 100)) {
+    if (ply > 0 && (board_is_repetition_draw(ply) || g_state.fifty_clock >= 100)) {
         return SCORE_DRAW;
     }
 
-    /* TT probe */
-    {
-        s16 tt_score;
-        Move tt_move;
-        tt_move.from = 0; tt_move.to = 0; tt_move.flags = 0; tt_move.score = 0;
+#ifndef TARGET_C64
+    /* Upcoming repetition: if a move back to an earlier position of this
+     * line exists, the side to move can always claim at least a draw */
+    if (ply > 0 && alpha < SCORE_DRAW && board_has_game_cycle(ply)) {
+        alpha = SCORE_DRAW;
+        if (alpha >= beta) return alpha;
+    }
+#endif
 
-        if (ply > 0 && tt_probe(g_state.hash, depth, alpha, beta,
-                                 &tt_score, &tt_move, ply)) {
-            return tt_score;
+    /* TT probe (not while searching with a move excluded: the entry is
+     * this node's own) */
+    tt_found = tt_probe_entry(g_state.hash, ply, &tt_hit);
+    if (tt_found) {
+        if (ply > 0 && IS_MOVE_NONE(excluded) &&
+            tt_cutoff(&tt_hit, depth, alpha, beta, &score)) {
+            return score;
         }
         /* Even if no score cutoff, we may have a best move for ordering */
-        if (tt_move.from != 0 || tt_move.to != 0) {
-            pv_move = tt_move;
+        if (!IS_MOVE_NONE(tt_hit.best_move)) {
+            pv_move = tt_hit.best_move;
             has_pv = 1;
         }
     }
 
     /* Leaf node: quiescence search */
     if (depth == 0) {
-        return quiescence(alpha, beta, ply);
+        return quiescence(alpha, beta, ply, 0);
     }
 
     g_search_info.nodes++;
@@ -168,11 +279,69 @@ static s16 negamax(s16 alpha, s16 beta, u8 depth, u8 ply, u8 do_null) {
         depth++;
     }
 
+    /* Internal iterative reduction: with no TT move the moves come in
+     * plain generation order, so a full-depth search is mostly wasted; a
+     * shallower one is cheaper and leaves a TT move for the next visit.
+     * Never at the root, which must reach the depth it reports, nor in a
+     * singular search, whose depth is already chosen by its caller. */
+    if (ply > 0 && depth >= IIR_DEPTH && !has_pv && IS_MOVE_NONE(excluded)) {
+        depth--;
+    }
+#ifdef TARGET_TEST
+    if (ply == 0) g_search_info.root_depth = depth;
+#endif
+
+    /* Static eval, and whether it improved on ours two plies up (if that
+     * one was in check, or this is near the root, assume so) */
+    static_eval = in_check ? EVAL_NONE : eval_position();
+    eval_stack[ply] = static_eval;
+    improving = 0;
+    if (!in_check) {
+        improving = (ply < 2 || eval_stack[ply - 2] == EVAL_NONE ||
+                     static_eval > eval_stack[ply - 2]);
+    }
+
+    /* Static forward pruning at non-PV nodes near the horizon: the static
+     * eval alone decides that a full search of this node is not needed */
+    if (ply > 0 && !in_check && !pv_node && depth <= RFP_DEPTH &&
+        IS_MOVE_NONE(excluded)) {
+        /* Reverse futility pruning: still above beta after giving up
+         * the margin, the node fails high */
+        if ((pruning & PRUNE_RFP) && !IS_MATE_SCORE(beta) &&
+            static_eval - rfp_margin[depth] >= beta) {
+            return beta;
+        }
+
+        /* Razoring: so far below alpha that only captures could help. One
+         * ply from the horizon quiescence gives the score; deeper, the node
+         * fails low if quiescence stays below alpha minus the margin. */
+        if ((pruning & PRUNE_RAZORING) && depth <= RAZOR_DEPTH &&
+            !IS_MATE_SCORE(alpha) &&
+            static_eval + razor_margin[depth] <= alpha) {
+            s16 r_alpha;
+
+            if (depth == 1) return quiescence(alpha, beta, ply, 0);
+            r_alpha = alpha - razor_margin[depth];
+            score = quiescence(r_alpha, r_alpha + 1, ply, 0);
+            if (g_search_info.stopped) return 0;
+            if (score <= r_alpha) return alpha;
+        }
+
+        /* Futility pruning: quiet moves will be skipped below */
+        futile = ((pruning & PRUNE_FUTILITY) && depth <= FUTILITY_DEPTH &&
+                  !IS_MATE_SCORE(alpha) &&
+                  static_eval + futility_margin[depth] <= alpha);
+
+        /* Late move pruning: quiet moves past a count will be skipped */
+        late_prune = ((pruning & PRUNE_LMP) && depth <= LMP_DEPTH);
+    }
+
     /* Null Move Pruning:
      * If we can give the opponent a free move and still get a beta cutoff,
      * this position is probably too good to bother searching fully.
      * Skip when: in check, at low depth, or in endgame (zugzwang risk). */
-    if (do_null && !in_check && depth >= 4 && !eval_is_endgame()) {
+    if (do_null && !in_check && depth >= 4 && IS_MOVE_NONE(excluded) &&
+        !eval_is_endgame()) {
         u8 R = 3; /* reduction */
         if (depth > 6) R = 4;
 
@@ -182,6 +351,9 @@ static s16 negamax(s16 alpha, s16 beta, u8 depth, u8 ply, u8 do_null) {
          * an ancestor ply's buffer space, corrupting their moves. */
         g_state.move_buf_idx[ply + 1] = g_state.move_buf_idx[ply];
 
+#ifndef TARGET_C64
+        movesort_set_played(ply, MOVE_NONE);
+#endif
         board_make_null();
         score = -negamax(-beta, -beta + 1, (u8)(depth - 1 - R), ply + 1, 0);
         board_unmake_null();
@@ -192,35 +364,89 @@ static s16 negamax(s16 alpha, s16 beta, u8 depth, u8 ply, u8 do_null) {
         }
     }
 
-    /* Generate moves */
-    num_moves = movegen_generate(ply);
-    base_idx = g_state.move_buf_idx[ply];
+    /* Singular extension: the TT move failed high before. If every other
+     * move fails low against a bound a little under its score, in a
+     * search of half the depth, the TT move is the only good one here and
+     * is searched one ply deeper. */
+    if (ply > 0 && depth >= SE_DEPTH && has_pv && IS_MOVE_NONE(excluded) &&
+        tt_hit.flag != TT_FLAG_ALPHA && tt_hit.depth + 3 >= depth &&
+        !IS_MATE_SCORE(tt_hit.score) && ply < g_search_info.max_depth * 2) {
+        s16 s_beta = tt_hit.score - SE_MARGIN * depth;
 
-    /* Score moves for ordering */
-    movesort_score_moves(ply, num_moves, has_pv ? &pv_move : NULL);
+        excluded_moves[ply] = pv_move;
+        score = negamax(s_beta - 1, s_beta, (u8)((depth - 1) / 2), ply, 0);
+        excluded_moves[ply] = MOVE_NONE;
+        pv_length[ply] = ply;
 
-    /* Search all moves */
-    for (i = 0; i < num_moves; i++) {
-        Move saved_move;
-        movesort_pick_best(ply, i, num_moves);
+        if (g_search_info.stopped) return 0;
+        if (score < s_beta) extension = 1;
+    }
+
+    /* Moves come from the staged picker: TT move, captures, killers,
+     * then quiets (or evasions when in check), generated as needed */
+    movepicker_init(&mp, ply, has_pv ? &pv_move : NULL, in_check);
 
-        saved_move = g_state.move_buf[base_idx + i];
-        if (!board_make_move(saved_move)) continue;
+    /* Search all moves */
+    while (movepicker_next(&mp, &saved_move)) {
+#ifndef TARGET_C64
+        if (ply == 0 && !is_root_move(saved_move)) continue;
+#endif
+        if (saved_move == excluded) continue;
         legal_moves++;
+        quiet = !(MOVE_FLAGS(saved_move) & (MF_CAPTURE | MF_PROMO));
+        gives_check = board_gives_check(saved_move);
+
+        /* Futility and late move pruning: past the first move, a quiet
+         * move that gives no check is skipped if it cannot lift this
+         * node's eval up to alpha, or once enough moves were searched.
+         * It is decided before the move is made, so a pruned move costs
+         * no make/unmake. */
+        if (legal_moves > 1 && quiet && !gives_check &&
+            (futile || (late_prune && legal_moves > lmp_count[improving][depth]))) {
+            continue;
+        }
 
-        /* Late Move Reductions (LMR):
-         * After searching a few moves fully, reduce depth for later quiet moves.
-         * They're unlikely to be best. If reduced search surprises us, re-search. */
-        if (legal_moves > 4 && depth >= 3 && !in_check &&
-            !(saved_move.flags & (MF_CAPTURE | MF_PROMO))) {
-            /* Reduced depth search */
-            score = -negamax(-alpha - 1, -alpha, depth - 2, ply + 1, 1);
-            if (score > alpha) {
-                /* Re-search at full depth if LMR found something */
+#ifndef TARGET_C64
+        movesort_set_played(ply, saved_move);
+#endif
+        board_make_legal_move(saved_move);
+
+        /* Principal Variation Search: the first move gets the full window;
+         * the rest only have to be shown no better than it, with a null
+         * window (alpha, alpha + 1).
+         * Late Move Reductions (LMR): later quiet moves are tried shallower,
+         * by lmr_table's log(depth) * log(move number), one ply less at PV
+         * nodes, for killers and for checking moves, one more when the
+         * eval is not improving. A move that beats alpha is searched
+         * again at full depth: with the null window at non-PV nodes, and
+         * straight with the full window at PV nodes (beta > alpha + 1),
+         * where any fail-high inside the window needs the exact score.
+         * No move is searched more than twice. */
+        if (legal_moves == 1) {
+            u8 new_depth = depth - 1;
+            if (has_pv && saved_move == pv_move) new_depth += extension;
+            score = -negamax(-beta, -alpha, new_depth, ply + 1, 1);
+        } else {
+            u8 reduce = 0;
+
+            if (depth >= 3 && quiet && !in_check) {
+                s8 r = (s8)lmr_table[depth < LMR_MAX ? depth : LMR_MAX - 1]
+                                    [legal_moves < LMR_MAX ? legal_moves : LMR_MAX - 1];
+                if (pv_node) r--;
+                if (saved_move == mp.killer[0] || saved_move == mp.killer[1]) r--;
+                if (gives_check) r--;
+                if (!improving) r++;
+                if (r > (s8)(depth - 2)) r = (s8)(depth - 2);
+                if (r > 0) reduce = (u8)r;
+            }
+
+            score = -negamax(-alpha - 1, -alpha, depth - 1 - reduce, ply + 1, 1);
+            if (reduce && score > alpha && beta == alpha + 1) {
+                score = -negamax(-alpha - 1, -alpha, depth - 1, ply + 1, 1);
+            }
+            if (score > alpha && score < beta) {
                 score = -negamax(-beta, -alpha, depth - 1, ply + 1, 1);
             }
-        } else {
-            score = -negamax(-beta, -alpha, depth - 1, ply + 1, 1);
         }
 
         board_unmake_move(saved_move);
@@ -246,67 +472,96 @@ static s16 negamax(s16 alpha, s16 beta, u8 depth, u8 ply, u8 do_null) {
                 }
 
                 if (score >= beta) {
-                    /* Beta cutoff - update killers */
+                    /* Beta cutoff - update killers and history */
                     movesort_update_killers(ply, saved_move);
-                    tt_store(g_state.hash, depth, beta, TT_FLAG_BETA,
-                             best_move, ply);
+#ifndef TARGET_C64
+                    movesort_update_quiet_stats(ply, saved_move, quiets,
+                                                quiet_count, depth);
+#endif
+                    if (store_tt) {
+                        tt_store(g_state.hash, depth, beta, TT_FLAG_BETA,
+                                 best_move, ply);
+                    }
                     return beta;
                 }
             }
         }
+#ifndef TARGET_C64
+        if (!(MOVE_FLAGS(saved_move) & (MF_CAPTURE | MF_PROMO)) &&
+            quiet_count < 64) {
+            quiets[quiet_count++] = saved_move;
+        }
+#endif
     }
 
     /* No legal moves: checkmate or stalemate */
     if (legal_moves == 0) {
+        /* Only the excluded move: it is singular */
+        if (!IS_MOVE_NONE(excluded)) return alpha;
         if (in_check) {
             return -SCORE_MATE + ply; /* checkmate */
         }
         return SCORE_DRAW; /* stalemate */
     }
 
-    /* Store in TT */
-    tt_store(g_state.hash, depth, best_score, tt_flag, best_move, ply);
+    /* Store in TT (a search with a move excluded has no score of its own) */
+    if (store_tt) {
+        tt_store(g_state.hash, depth, best_score, tt_flag, best_move, ply);
+    }
 
     return best_score;
 }
 
 /* --- Iterative Deepening --- */
 
-SearchResult search_position(u8 max_depth, u32 max_time_ms) {
+#ifndef TARGET_C64
+/* Nodes searched so far by all threads */
+static u32 total_nodes(void) {
+    u32 nodes = g_search_info.nodes;
+    u8 i;
+    for (i = 0; i < helper_count; i++) {
+        nodes += helpers[i]->search_info.nodes;
+    }
+    return nodes;
+}
+#endif
+
+/* Iterative deepening with aspiration windows on the current engine,
+ * whose g_search_info is set up. thread 0 is the main search; helper
+ * threads skip depths in a per-thread pattern so that the threads spread
+ * over neighbouring depths, and print nothing. */
+static SearchResult iterate(u8 thread) {
     SearchResult result;
     u8 depth;
     s16 score;
     Move best_move_so_far;
 
-    result.best_move.from = 0;
-    result.best_move.to = 0;
-    result.best_move.flags = 0;
-    result.best_move.score = 0;
+    result.best_move = MOVE_NONE;
     result.score = 0;
     result.depth = 0;
     result.nodes = 0;
 
-    best_move_so_far.from = 0;
-    best_move_so_far.to = 0;
-    best_move_so_far.flags = 0;
-    best_move_so_far.score = 0;
+    best_move_so_far = MOVE_NONE;
 
     /* Set up move buffer for ply 0 */
     g_state.move_buf_idx[0] = 0;
 
-    /* Initialize search info */
-    g_search_info.nodes = 0;
-    g_search_info.max_depth = max_depth;
-    g_search_info.max_time_ms = max_time_ms;
-    g_search_info.start_time = get_time_ms();
-    g_search_info.stopped = 0;
-    g_search_info.use_time = (max_time_ms > 0) ? 1 : 0;
-
     movesort_clear_killers();
+#ifndef TARGET_C64
+    movesort_age_history();
+#endif
 
-    /* Iterative deepening with aspiration windows */
-    for (depth = 1; depth <= max_depth; depth++) {
+    for (depth = 1; depth <= g_search_info.max_depth; depth++) {
         s16 alpha_w, beta_w;
+
+#ifndef TARGET_C64
+        if (thread > 0) {
+            u8 i = (u8)((thread - 1) % 20);
+            if (((depth + skip_phase[i]) / skip_size[i]) & 1) continue;
+        }
+#else
+        (void)thread;
+#endif
         pv_length[0] = 0;
 
         /* Use aspiration window after depth 4 */
@@ -341,23 +596,25 @@ SearchResult search_position(u8 max_depth, u32 max_time_ms) {
 
 #ifndef TARGET_C64
         /* Print UCI info */
-        {
+        if (thread == 0 && !g_engine->info_off) {
+            u32 nodes = total_nodes();
             u32 elapsed = get_time_ms() - g_search_info.start_time;
-            u32 nps = elapsed > 0 ? (g_search_info.nodes * 1000 / elapsed) : 0;
+            u32 nps = elapsed > 0 ? (u32)((double)nodes * 1000 / elapsed) : 0;
             u8 j;
             char from_str[3], to_str[3];
 
             printf("info depth %d score cp %d nodes %lu time %lu nps %lu pv",
-                   depth, score, (unsigned long)g_search_info.nodes,
+                   depth, score, (unsigned long)nodes,
                    (unsigned long)elapsed, (unsigned long)nps);
 
             for (j = 0; j < pv_length[0]; j++) {
-                sq_to_str(pv_table[0][j].from, from_str);
-                sq_to_str(pv_table[0][j].to, to_str);
+                Move pv = pv_table[0][j];
+                sq_to_str(MOVE_FROM(pv), from_str);
+                sq_to_str(MOVE_TO(pv), to_str);
                 printf(" %s%s", from_str, to_str);
-                if (pv_table[0][j].flags & MF_PROMO) {
+                if (MOVE_FLAGS(pv) & MF_PROMO) {
                     static const char promo_chars[] = "nbrq";
-                    printf("%c", promo_chars[PROMO_TYPE(pv_table[0][j].flags) - KNIGHT]);
+                    printf("%c", promo_chars[PROMO_TYPE(MOVE_FLAGS(pv)) - KNIGHT]);
                 }
             }
             printf("\n");
@@ -371,3 +628,123 @@ SearchResult search_position(u8 max_depth, u32 max_time_ms) {
 
     return result;
 }
+
+#ifndef TARGET_C64
+static void helper_run(Engine *h) {
+    engine_set_current(h);
+    h->helper_result = iterate(h->helper_id);
+}
+
+#ifdef _WIN32
+typedef HANDLE SearchThread;
+
+static DWORD WINAPI helper_thread(LPVOID arg) {
+    helper_run((Engine *)arg);
+    return 0;
+}
+#else
+typedef pthread_t SearchThread;
+
+static void *helper_thread(void *arg) {
+    helper_run((Engine *)arg);
+    return NULL;
+}
+#endif
+
+/* Main search plus helpers. The helpers start from a copy of the root
+ * position and keep no clock of their own. */
+static SearchResult search_smp(void) {
+    SearchThread threads[SEARCH_MAX_THREADS - 1];
+    SearchResult result;
+    u8 i;
+
+    for (i = 0; i < helper_count; i++) {
+        Engine *h = helpers[i];
+        memcpy(&h->state, &g_state, sizeof(GameState));
+        h->search_info = g_search_info;
+        h->search_info.use_time = 0;
+        h->pruning_off = g_engine->pruning_off;
+        h->tt = g_engine->tt;
+        h->helper_id = (u8)(i + 1);
+        h->helper_result.best_move = MOVE_NONE;
+        h->helper_result.depth = 0;
+        h->smp_stop = 0;
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, helper_thread, (LPVOID)h, 0, NULL);
+#else
+        pthread_create(&threads[i], NULL, helper_thread, (void *)h);
+#endif
+    }
+
+    result = iterate(0);
+
+    for (i = 0; i < helper_count; i++) {
+        helpers[i]->smp_stop = 1;
+    }
+    for (i = 0; i < helper_count; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    /* The main result stands unless a helper completed a deeper iteration */
+    for (i = 0; i < helper_count; i++) {
+        SearchResult *r = &helpers[i]->helper_result;
+        if (!IS_MOVE_NONE(r->best_move) && r->depth > result.depth) {
+            result.best_move = r->best_move;
+            result.score = r->score;
+            result.depth = r->depth;
+        }
+    }
+    result.nodes = total_nodes();
+    return result;
+}
+
+u8 search_set_threads(u16 n) {
+    if (n < 1) n = 1;
+    if (n > SEARCH_MAX_THREADS) n = SEARCH_MAX_THREADS;
+
+    while (helper_count + 1 < n) {
+        helpers[helper_count] = engine_create(g_engine);
+        if (!helpers[helper_count]) break;
+        helper_count++;
+    }
+    while (helper_count + 1 > n) {
+        helper_count--;
+        engine_destroy(helpers[helper_count]);
+        helpers[helper_count] = NULL;
+    }
+    return (u8)(helper_count + 1);
+}
+
+void search_set_info_output(u8 on) {
+    g_engine->info_off = !on;
+}
+
+void search_set_root_moves(const Move *moves, u16 count) {
+    u16 i;
+    if (count > MAX_MOVES) count = MAX_MOVES;
+    for (i = 0; i < count; i++) {
+        g_search_info.root_moves[i] = moves[i];
+    }
+    g_search_info.root_move_count = count;
+}
+#endif
+
+SearchResult search_position(u8 max_depth, u32 max_time_ms) {
+    /* Initialize search info */
+    g_search_info.nodes = 0;
+    g_search_info.max_depth = max_depth;
+    g_search_info.max_time_ms = max_time_ms;
+    g_search_info.start_time = get_time_ms();
+    g_search_info.stopped = 0;
+    g_search_info.use_time = (max_time_ms > 0) ? 1 : 0;
+
+#ifndef TARGET_C64
+    if (helper_count > 0) return search_smp();
+#endif
+    return iterate(0);
+}
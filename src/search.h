@@ -6,36 +6,57 @@
 /*
  * Search Engine
  * - Iterative deepening
- * - Negamax with alpha-beta pruning
- * - Quiescence search
+ * - Negamax with alpha-beta pruning, as principal variation search
+ * - Quiescence search (captures, quiet checks at its first ply, evasions)
  * - Null move pruning
- * - Late move reductions
- * - Transposition table
+ * - Reverse futility pruning, razoring and futility pruning
+ * - Late move reductions (logarithmic table) and late move pruning
+ * - Transposition table, with internal iterative reductions and singular
+ *   extensions driven by its entries
+ * - Lazy SMP (PC): helper threads sharing the TT
  */
 
-/* Search result */
-typedef struct {
-    Move best_move;
-    s16  score;
-    u8   depth;
-    u32  nodes;
-} SearchResult;
-
-/* Search info (for UCI info output) */
-typedef struct {
-    u32  nodes;
-    u8   max_depth;     /* max depth to search */
-    u32  max_time_ms;   /* max time in milliseconds (0 = no limit) */
-    u32  start_time;    /* search start timestamp */
-    u8   stopped;       /* set to 1 to abort search */
-    u8   use_time;      /* 1 if time control is active */
-} SearchInfo;
-
-extern SearchInfo g_search_info;
+/* Search info of the current engine (SearchInfo and SearchResult are in
+ * types.h) */
+#define g_search_info (g_engine->search_info)
 
 /* Run iterative deepening search. Returns best move and score. */
 SearchResult search_position(u8 max_depth, u32 max_time_ms);
 
+/* Static forward pruning techniques, for search_set_pruning. Each one
+ * only acts at non-PV nodes out of check, within a few plies of the
+ * horizon (margins and move counts by depth in search.c). */
+#define PRUNE_RFP       0x01  /* reverse futility: eval - margin >= beta */
+#define PRUNE_RAZORING  0x02  /* eval + margin <= alpha: quiescence decides */
+#define PRUNE_FUTILITY  0x04  /* eval + margin <= alpha: skip quiet moves */
+#define PRUNE_LMP       0x08  /* skip quiet moves past a move count */
+#define PRUNE_ALL       0x0F
+
+/* Enable the techniques in mask and disable the rest, for the current
+ * engine and the helpers it searches with (default PRUNE_ALL) */
+void search_set_pruning(u8 mask);
+u8 search_get_pruning(void);
+
+#ifndef TARGET_C64
+/* Lazy SMP: the current engine's search_position runs on the calling
+ * thread plus n - 1 helper threads, each with an engine of its own
+ * (position, move buffer, killers, PV) and all sharing the calling
+ * engine's TT. Helpers search the same root with staggered depths; the
+ * main thread's result is used unless a helper completed a deeper
+ * iteration. The helpers belong to the engine (engine_destroy frees
+ * them), so several engines can search with threads at once. Returns the
+ * thread count set (clamped to 1..SEARCH_MAX_THREADS, fewer if out of
+ * memory). */
+u8 search_set_threads(u16 n);
+
+/* Print UCI info lines while the current engine searches (default on) */
+void search_set_info_output(u8 on);
+
+/* Restrict the root of the following searches to these moves (UCI go
+ * searchmoves); count 0 searches all moves again */
+void search_set_root_moves(const Move *moves, u16 count);
+#endif
+
 /* Get current time in milliseconds (platform-specific) */
 u32 get_time_ms(void);
 
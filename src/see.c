@@ -0,0 +1,190 @@
+#include "see.h"
+#include "tables.h"
+
+/* Exchange values by piece type. Knight and bishop are equal so that
+ * trading one for the other counts as even, not as a loss. */
+static const s16 see_value[7] = { 0, 100, 325, 325, 500, 900, 20000 };
+
+/* attack_table bit of each [color][piece type] */
+static const u8 see_atk_bit[2][7] = {
+    { 0, ATK_WPAWN, ATK_KNIGHT, ATK_BISHOP, ATK_ROOK, ATK_QUEEN, ATK_KING },
+    { 0, ATK_BPAWN, ATK_KNIGHT, ATK_BISHOP, ATK_ROOK, ATK_QUEEN, ATK_KING }
+};
+
+/* At most 16 pieces a side can join in, plus the mover and an ep pawn */
+#define SEE_MAX_ATTACKERS 16
+#define SEE_MAX_CLEARED   34
+
+/* One exchange in progress. Pieces that have taken part are lifted off
+ * g_state.board (so rays see through them) and put back by see_restore. */
+typedef struct {
+    u8 to;
+    u8 atk_sq[2][SEE_MAX_ATTACKERS];     /* attackers of 'to' not yet used */
+    u8 atk_count[2];
+    u8 cleared_sq[SEE_MAX_CLEARED];
+    u8 cleared_piece[SEE_MAX_CLEARED];
+    u8 cleared_count;
+} SeeState;
+
+static void see_clear(SeeState *ss, u8 sq) {
+    ss->cleared_sq[ss->cleared_count] = sq;
+    ss->cleared_piece[ss->cleared_count] = g_state.board[sq];
+    ss->cleared_count++;
+    g_state.board[sq] = EMPTY;
+}
+
+static void see_restore(SeeState *ss) {
+    while (ss->cleared_count) {
+        ss->cleared_count--;
+        g_state.board[ss->cleared_sq[ss->cleared_count]] =
+            ss->cleared_piece[ss->cleared_count];
+    }
+}
+
+/* Is every square strictly between sq and the target empty? */
+static u8 see_path_clear(u8 sq, u8 to) {
+    s8 step = delta_table[ATTACK_INDEX(sq, to)];
+    u8 s;
+    for (s = (u8)(to + step); s != sq; s = (u8)(s + step)) {
+        if (g_state.board[s] != EMPTY) return 0;
+    }
+    return 1;
+}
+
+static void see_add(SeeState *ss, u8 color, u8 sq) {
+    ss->atk_sq[color][ss->atk_count[color]] = sq;
+    ss->atk_count[color]++;
+}
+
+/* Every piece of both sides that attacks the target through the board as
+ * it stands (the mover already lifted, so pieces behind it count) */
+static void see_gather(SeeState *ss) {
+    u8 color, pt, n, sq, atk;
+
+    ss->atk_count[WHITE] = 0;
+    ss->atk_count[BLACK] = 0;
+    for (color = WHITE; color <= BLACK; color++) {
+        for (pt = PAWN; pt <= KING; pt++) {
+            for (n = 0; n < g_state.piece_count[color][pt]; n++) {
+                sq = g_state.piece_list[color][pt][n];
+                if (g_state.board[sq] == EMPTY) continue;  /* lifted */
+                atk = attack_table[ATTACK_INDEX(sq, ss->to)] & see_atk_bit[color][pt];
+                if (!atk) continue;
+                if (pt >= BISHOP && pt <= QUEEN && !see_path_clear(sq, ss->to)) continue;
+                see_add(ss, color, sq);
+            }
+        }
+    }
+}
+
+/* sq has just been lifted: the first piece behind it on the line away
+ * from the target joins in if it is a slider moving along that line.
+ * Knights are on no line with the target (step 0); pawns and kings two
+ * or more squares away never match their attack_table bits. */
+static void see_add_xray(SeeState *ss, u8 sq) {
+    s8 step = delta_table[ATTACK_INDEX(sq, ss->to)];
+    u8 piece;
+
+    if (step == 0) return;
+    for (sq = (u8)(sq + step); SQ_VALID(sq); sq = (u8)(sq + step)) {
+        piece = g_state.board[sq];
+        if (piece == EMPTY) continue;
+        if (attack_table[ATTACK_INDEX(sq, ss->to)] &
+            see_atk_bit[PIECE_COLOR(piece)][PIECE_TYPE(piece)]) {
+            see_add(ss, PIECE_COLOR(piece), sq);
+        }
+        return;
+    }
+}
+
+/* Take the least valuable unused attacker of color off its list; SQ_NONE
+ * if there is none */
+static u8 see_pop_least(SeeState *ss, u8 color) {
+    u8 i, best_i = 0, best_sq;
+    u8 count = ss->atk_count[color];
+    s16 v, best_v = 0x7FFF;
+
+    if (count == 0) return SQ_NONE;
+    for (i = 0; i < count; i++) {
+        v = see_value[PIECE_TYPE(g_state.board[ss->atk_sq[color][i]])];
+        if (v < best_v) {
+            best_v = v;
+            best_i = i;
+        }
+    }
+    best_sq = ss->atk_sq[color][best_i];
+    ss->atk_count[color] = --count;
+    ss->atk_sq[color][best_i] = ss->atk_sq[color][count];
+    return best_sq;
+}
+
+s16 see(Move m) {
+    SeeState ss;
+    s16 gain[SEE_MAX_CLEARED];
+    s16 on_square;
+    u8 from = MOVE_FROM(m), flags = MOVE_FLAGS(m);
+    u8 side, d, sq, pt;
+
+    if (flags & MF_CASTLE) return 0;
+
+    ss.to = MOVE_TO(m);
+    ss.cleared_count = 0;
+
+    /* gain[d]: what the side making capture d has won if the exchange
+     * stops there; on_square: the piece now standing on the target */
+    on_square = see_value[PIECE_TYPE(g_state.board[from])];
+    if (flags & MF_EP) {
+        gain[0] = see_value[PAWN];
+        see_clear(&ss, g_state.side == WHITE ? (u8)(ss.to - 16) : (u8)(ss.to + 16));
+    } else {
+        gain[0] = see_value[PIECE_TYPE(g_state.board[ss.to])];
+    }
+    if (flags & MF_PROMO) {
+        on_square = see_value[PROMO_TYPE(flags)];
+        gain[0] += on_square - see_value[PAWN];
+    }
+    see_clear(&ss, from);
+    see_gather(&ss);
+
+    side = g_state.side ^ 1;
+    d = 0;
+    while ((sq = see_pop_least(&ss, side)) != SQ_NONE) {
+        pt = PIECE_TYPE(g_state.board[sq]);
+        d++;
+        gain[d] = on_square - gain[d - 1];
+        on_square = see_value[pt];
+        see_clear(&ss, sq);
+        see_add_xray(&ss, sq);
+        side ^= 1;
+
+        /* A king can only take when nothing can take it back */
+        if (pt == KING && ss.atk_count[side]) {
+            d--;
+            break;
+        }
+    }
+    see_restore(&ss);
+
+    /* Either side may stop instead of capturing: negamax back to the root */
+    for (; d > 0; d--) {
+        if (gain[d] > -gain[d - 1]) gain[d - 1] = -gain[d];
+    }
+    return gain[0];
+}
+
+u8 see_ge(Move m, s16 threshold) {
+    u8 flags = MOVE_FLAGS(m);
+    s16 captured;
+
+    if (flags & (MF_CASTLE | MF_EP | MF_PROMO)) return see(m) >= threshold;
+
+    /* Short of the threshold even if nothing takes back */
+    captured = see_value[PIECE_TYPE(g_state.board[MOVE_TO(m)])];
+    if (captured < threshold) return 0;
+
+    /* Still at the threshold after losing the moved piece for nothing */
+    if (captured - see_value[PIECE_TYPE(g_state.board[MOVE_FROM(m)])] >= threshold) {
+        return 1;
+    }
+    return see(m) >= threshold;
+}
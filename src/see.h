@@ -0,0 +1,24 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include "types.h"
+
+/*
+ * Static Exchange Evaluation
+ * Plays out the captures on a move's target square, least valuable
+ * attacker first, with either side free to stop, and returns the
+ * material balance for the side making the move. Attackers are found
+ * from the piece lists and 0x88 attack table; sliders hidden behind a
+ * piece that has taken part (x-rays) join the exchange when it leaves.
+ * Pins and checks are ignored.
+ */
+
+/* Material won (negative: lost) by m, which must be pseudo-legal.
+ * Quiet moves score what the moved piece stands to lose. */
+s16 see(Move m);
+
+/* see(m) >= threshold, usually decided without playing out the
+ * whole exchange */
+u8 see_ge(Move m, s16 threshold);
+
+#endif /* SEE_H */
@@ -1,4 +1,5 @@
 #include "tables.h"
+#include "bitboard.h"
 
 /*
  * Material values indexed by piece type
@@ -106,7 +107,7 @@ const s8 *pst_table[7] = {
 /*
  * Zobrist random numbers
  * C64: 16-bit values (fast on 6502, sufficient for 4KB TT)
- * PC: 32-bit values (far fewer hash collisions for larger TT)
+ * PC: 64-bit values from a seeded PRNG (see init_zobrist)
  */
 
 #ifdef TARGET_C64
@@ -341,238 +342,37 @@ const u16 zobrist_ep[8] = {
     0x79A8, 0x5BCA, 0x3DEC, 0x1F0E
 };
 
-#else /* PC build: 32-bit Zobrist for minimal hash collisions */
+#else /* PC build: 64-bit Zobrist, filled in by init_zobrist() */
 
-const u32 zobrist_pieces[2][7][128] = {
-/* WHITE pieces */
-{
- /* EMPTY */
- {0},
- /* PAWN */
- {0x92CAFEDB,0xFA2DF0F1,0x077C5FD8,0x9C7E1104,0x8B76704D,0x0CAB4849,0xB39CA55D,0x4FD4F0BA,
-  0x1F0BAD05,0xFE5A5AE2,0x2E408A02,0xB9476A18,0xF3ABB8DF,0xD5ACC649,0x426ED206,0x1213FF5F,
-  0x43ED674A,0xA87C01AF,0x07B0A4F7,0xB90FACC8,0x6D2FB3C1,0x6AB3CB45,0x7B9DCD35,0xF1009809,
-  0xE11137EB,0xC3B708E2,0xD43D008C,0x4B4F88EB,0x78C852AD,0x4ED8B629,0xF8072C1B,0x17D66E4C,
-  0xEFE4ADC0,0x84B08D7A,0x857DDA2B,0x99DD92C0,0xA87B5AC2,0xDAD79B7E,0x09EF534A,0x878D3FE9,
-  0x30644A6D,0x89F16ECB,0xCDE1E64F,0xF8173B54,0x04B4641D,0xFF8C9418,0x8A6007FD,0x575588E8,
-  0xBFD06D71,0x87ABFFF4,0xC4580903,0x753ACE6E,0x7DB6556F,0x377AE66C,0x6CD4A38C,0xE8A6E1AE,
-  0x45F6CFA4,0xD694C80A,0x2A29ABCF,0xF7DD3CEC,0x3C6C7B90,0x58674C59,0xC7D0A090,0x737A1ED2,
-  0x849203BE,0x949DF9E5,0x12B27539,0x810F9A1A,0x5FB76FE6,0x98A7CA3C,0x29D4C529,0x6EDE10C3,
-  0xCE9764EA,0xA6E5310C,0xE9293476,0xC9C5E46D,0x55B732B4,0x6397DE2A,0xC4030E2A,0x8D3CE017,
-  0x8283CECF,0x86B85068,0x8437E795,0x1F69F662,0x0A17D15C,0xB18EF3F5,0x2BB8D105,0x3CBDE1E5,
-  0x5392C2A4,0x3D8E8F20,0x6877F741,0xEFC3FFAB,0x341190CA,0x8006F94B,0xFF5D0238,0x86C6DB39,
-  0x20F6CADE,0xBD88C1DE,0xD4756659,0x14F17959,0xDEA87982,0x08217EDF,0x456F61D9,0x83219A98,
-  0xF7CE7EF1,0xC54CD31F,0x8DC38AC8,0x22B27863,0xF52B8D70,0x8414A44E,0xA77087D8,0x1A0E1CA4,
-  0xE81BA907,0x1528BD9E,0x9810D806,0xDC95712B,0x7D4DDD26,0x59457C1C,0xBAE57554,0xDB493DB4,
-  0x15AB77C3,0xE8B517B7,0x1A5B5C9A,0xF0F45EE6,0xD0D86D2A,0xE3F6C338,0x4AC483CF,0xA91FBFC1},
- /* KNIGHT */
- {0x3634E47D,0x270BAF30,0xF7A39F1F,0x2B823B99,0xB182F63E,0x867B7262,0x70D86BEB,0xF51B84B0,
-  0x40DADC75,0x00B2817A,0xD380779F,0x0BE3C8E9,0xEFA3C268,0x7A87FB54,0x05D78381,0xFB2E824D,
-  0xE7832E97,0xE2DB192D,0x1461B956,0x079AE7FD,0x3F9378B3,0xB923A6DF,0xAC8AE2A0,0x095BEE38,
-  0xE0D78FA2,0x9AAFF9DB,0x0DC7E6A9,0x5298566D,0xE614C79F,0xF0BB3BFB,0x752BE8E2,0x183305C8,
-  0xF31525A0,0x371DE12A,0xE436A091,0x8773BDFE,0x63010D82,0x66E7DDB7,0x68788737,0x3C9705E3,
-  0xE01E3837,0xD4D722CA,0x8A18E520,0xA42F5DAA,0xE52F606D,0x48F717A6,0x389F29B7,0xC6547D76,
-  0x3C50AC38,0x845131F8,0x8A442CFA,0xF176AAED,0xEA4E3D1E,0xB652FF70,0xE2A70919,0x0B59CBC6,
-  0x3489E24B,0xCB0373B1,0x05380792,0xD3FF4D34,0x610101FC,0x2CE2BCB3,0xB7A6B252,0x3811375B,
-  0xF5F5BD55,0xA404F47B,0x8C161A59,0x6ACC23BE,0x4A6A66F3,0xFF170CD0,0xE72F2A80,0x7A73509C,
-  0x8662D678,0x361BF7E7,0xFC37139F,0x5AEF103B,0xBDEDCFF2,0x9B115641,0xE1D9C015,0xD310A626,
-  0xE47756C5,0x284DC46C,0x1E66936A,0x476C10EA,0xBD146E90,0xD68CF86C,0x16F8C144,0x85CE9285,
-  0x0E9AD825,0xF3791802,0x2786D5D2,0x49F40412,0x1CC1972E,0x8CBD9965,0xEF92C8D9,0xA948245F,
-  0x3C925304,0x9CCB8DDE,0xC0385117,0xE32B68E1,0xB4772DAD,0xAB539397,0x9011AF7D,0xA0174AA6,
-  0x174A25C0,0x03B4160A,0xBAB62D74,0xA217700D,0x09D6AC2C,0xA04E0CF2,0xFB3E4F66,0x5F10CC4D,
-  0x9A3401AB,0x627A1565,0x5FF7B096,0x8F66EA45,0xEB6761D8,0x5F3009C8,0xDEE2E0D6,0x4FB92035,
-  0xFA550F26,0x43238099,0x974B9908,0xE4F083DD,0x37771DC0,0x5A91FE8E,0x2BBE496D,0x06763EFA},
- /* BISHOP */
- {0xC7288CDD,0x830035D6,0xF38294F5,0x8F233163,0xB156A439,0xCF50FE98,0x72E6F1F0,0xA1B8C842,
-  0x3748EE7A,0x542F16AD,0x4B48837C,0xDE6B5BD3,0xDB3C33AA,0xABFA5E9F,0xBB34BD8B,0x50BEF179,
-  0xF4B39222,0x8D5A1F88,0x5892A83E,0xBDD774C5,0xFD955967,0xC00966A4,0x8D407C1F,0xC94797DF,
-  0x16CA6ED1,0xDAB5C089,0xAE68465A,0xA3317927,0x8F978153,0x58931ED4,0x2097B765,0xE96C8C65,
-  0xE137473C,0xA987401C,0x05B2DBA8,0x3D29C30D,0x13DCF611,0xC49585C1,0x3329930B,0xD6102BDB,
-  0xD6994D08,0xE5B71149,0x04000E50,0x53A4C747,0xB5017668,0x31109DF2,0x428C9FC3,0x57813D29,
-  0xACE1B19D,0xA10E4BE0,0x4F9447AA,0x1608E573,0xB9C2CAF1,0xB50B910B,0x0F301576,0x1DA44FEA,
-  0x444BDB0B,0xB779E9E1,0x933B22E8,0x57E6A1B6,0x92E44B63,0x6BED2D76,0x7CFA37F7,0x6820678D,
-  0xD9AC8B3C,0xCB250050,0x5B73808F,0xFC893536,0x04C3BB7A,0x2B509663,0xE7197833,0x4BF27DF7,
-  0xBBE8CE1C,0x7FAA1FE9,0x660D9EFF,0xA0E7EF35,0xA12FB232,0x4719C319,0x1CBD63A7,0xBE4F4840,
-  0xA5B41D11,0xE8BB0F40,0x8BE5AB32,0xA93F883E,0x2E4C502A,0x94E8016B,0xA0CCAD0D,0xF6AD8CB1,
-  0x7EE4415B,0xE6CB610B,0x77FA794B,0x289E4B6F,0xCB8EB996,0x8501ACAF,0x343B7949,0x4411200E,
-  0x6C98654B,0x160C7DF1,0x43E32054,0x0EB3E3F3,0xC79589B8,0xA4F64D6D,0x542C747C,0x4FC8B380,
-  0x79B4CFBB,0xDAD7F965,0xA72E2354,0x6AD55D9E,0x34EE8452,0xC3236445,0xFE3110F6,0x7733D948,
-  0x08FB89DE,0x3FB27A92,0x3EF25907,0x8795062D,0x5FDE2933,0x37971342,0x3E7E7698,0xDDDA65FA,
-  0x84E716E7,0x3EE188F9,0x9D4BC4DD,0x6840D26A,0x2F7122FA,0x6027FD6C,0xB9222A4A,0x5BB3453D},
- /* ROOK */
- {0xD62B9340,0xD4215513,0x7EBBA1C6,0x1D4452A0,0x166BB8A1,0x0F70E56B,0xA992EECF,0xE4D7726F,
-  0x46254C56,0xEBE40094,0x0AB23B81,0xDEBF0F83,0x81DE2C45,0x522B6D62,0xE8F98FED,0x73FBA83E,
-  0x41AC9F0E,0xBA413BCF,0xB64C5308,0x382CF358,0x1381D97D,0x61AF3C1B,0x08F332CF,0x2011B4C9,
-  0x14D0B98C,0x29F1A1F8,0x796BD27E,0x062B72D7,0xEE0ED010,0xA7931CDD,0x0EB203B1,0xDF41ECDF,
-  0x79B951C1,0x3C156A16,0x378E2EE4,0x70E36F9E,0x004BE67E,0x35516EF1,0xDC1EBD25,0x44AB7F05,
-  0xBECF12F0,0xA56E3328,0x1734DDC8,0x65C50849,0xEF0722BB,0xF491E3D3,0x7DD82749,0x2834D05D,
-  0x1255A1F1,0x6C3AB9D3,0x188A9106,0xBEE706F6,0x8F7D0C46,0x841FD2AF,0x64AAD606,0x9543CCCD,
-  0x04256921,0xEDE07ED5,0xEC2E25B4,0xC40711F1,0x713C78ED,0x042DCFA8,0xA992862F,0x2C94E8C3,
-  0x482C244C,0xC34923C5,0xECD6ED7B,0x62606F62,0xD64A5EB0,0xFDB4271D,0xA0C20371,0x7B93D82F,
-  0xF2C6E190,0x879C995B,0x74FFBB77,0xB6EC36E7,0x14D186E5,0x033883BD,0x90ADF50B,0xF91F70CF,
-  0x2EE42AC8,0x72F97219,0x4D6595AE,0x4CCE154E,0x033DAF18,0x33684482,0x668CBAA1,0xFE0A4A31,
-  0x10652FB9,0x67EABE44,0xE4A1682A,0x22DAAC5D,0xB3BFF585,0x90E0E8D6,0x00726363,0xA1639ED1,
-  0xD7F0D61F,0xFBDF0842,0xEAD29492,0xEBACC31F,0x404D2350,0xE51C383F,0x98FCFC65,0xABA07FCB,
-  0xC8A264D1,0xF47DED23,0xE276DDCB,0xB62A0DEB,0x7D671462,0xE4966D6B,0xE069FADA,0x0BC40551,
-  0x225B43E2,0x53544BEE,0xE35E2166,0x3BCDAD54,0x01BBA6C8,0x0D55CE7C,0x439070FD,0xE0DC246A,
-  0x84BA7033,0x23DEA83D,0x45172E12,0xC0BC3125,0xA107B777,0x57115607,0xB4F994D4,0x2D696F7D},
- /* QUEEN */
- {0xAAFA6057,0x5541E52D,0x6FA09557,0x1A20824D,0x7EB814A6,0xC50B2C33,0x3AAC81E5,0xB1CC5A72,
-  0x1F9EC11A,0x2DFF1CD1,0xB0C68C6E,0x092B77F9,0x1DCCD4E4,0xA188AF28,0x07830C96,0xFE58394B,
-  0xE06AFC2D,0xA37E5C93,0xD3475C90,0x003EA798,0xD7262BAE,0xFEE79465,0x05AA9462,0x5584CEBC,
-  0xBD1B718F,0xCE6D06CC,0x0D21C3A8,0xEB0AEB73,0x80452D7F,0xD12934DE,0xAE1C4EE0,0x8CB7EEFE,
-  0xF23BB02B,0x691B3255,0x783EF2C5,0x71C3BB85,0xA2A52CCC,0xF8D25E88,0xB6154DB6,0x992EA1CD,
-  0xFEEF8BB6,0x8C8F713B,0xB4AEE861,0xFF052A96,0x3C7EFB6A,0xE540824D,0x72AF261D,0xC2797967,
-  0x1C7592ED,0x9E04A766,0x82DE53FB,0x79465BFD,0xFC553F90,0x746E3D9C,0x3BD7B4A8,0x2A62245C,
-  0x83DA659D,0x92DC2FFE,0xF9CDBBA9,0xEB1D92D3,0xCDBE7044,0x86EF49E3,0x60EFBAEC,0x0326B843,
-  0xEF415DE0,0x16FE68A5,0xDBF37FFD,0xA7FF11C7,0x933EF87B,0xEF15A46E,0x8D53B417,0x7C7496E3,
-  0x8503A29F,0x0664ADFD,0x607F7A1D,0x473FF9D1,0xBF2DDEFA,0x0B211A9E,0x2F7D404C,0xC49A0492,
-  0x3B6ADDB4,0x2570F143,0x3EB14C8D,0x97B9F574,0xC1F10616,0x6D588748,0x5D56F039,0x1AC9D635,
-  0xD79743DA,0x53EF7FF5,0xE730595C,0x4CDB27EC,0x93FF3747,0xF3D4EA1C,0xA53D78E1,0xA8622820,
-  0xC63D865C,0x5CDE174E,0x6AD511B0,0x5546D79A,0x65F49F64,0xC7C41C1D,0x7E442C13,0xD78AFA23,
-  0x770E9AFE,0xD0891064,0x6382E240,0xC259C7DE,0xCBC7DA52,0x1A1DFE74,0xCF61E947,0x388E822C,
-  0x8EDC74AB,0xD5935B3D,0x271882CB,0x11BB8643,0x45DED959,0x5CDC41F1,0x3BA7F3DD,0x7158D021,
-  0xC688AF21,0xF98F2AD9,0x743233A5,0x912FA2E0,0x7C5F8582,0x765E60F4,0xD16B3B63,0x0C53CA56},
- /* KING */
- {0x270C906B,0xDC89D43B,0x51060ECB,0xD4F48E57,0x20D4DD92,0x1B9B6DC1,0x73C4D87A,0xBC3FD23D,
-  0x9F51F9B6,0x4B6042FB,0x34AAA219,0x96D43B79,0x95D8FD43,0xAFFB7E76,0x57987D42,0x8EC15D96,
-  0x4F395BDB,0x9F51BF51,0xD308EC40,0x55C53D7B,0xA4930DDC,0xB9F97D82,0x46FC623C,0x64CDDDD9,
-  0xD5906D57,0x243F4178,0x3843C42C,0xFF6B296A,0x9FF7BE24,0x1B0F738E,0xE2056EE6,0xC47AA0F7,
-  0xAB98DB83,0xEE367BC5,0xA4B1EB5A,0x58B2D0A3,0x59ADC96C,0x91BAA23C,0x8A77AC2D,0xE92F2A45,
-  0xC13ACA60,0x297855B4,0xB4210F8E,0xCE170168,0x65351CD1,0xD5A157DB,0xA64FE780,0x77FB7EAB,
-  0x853C7CDD,0x3149A0F8,0x3E2EA86F,0x1AF5BB09,0xE00D85EE,0x76B0A9F5,0x85267F8E,0xE02098F1,
-  0x263DC0CD,0xAA88D6F7,0x244A47E6,0x0C1AEF0A,0x1AF853A7,0x10F55763,0x18789759,0xA4153E98,
-  0x094A5296,0xBE7A5EE4,0x53DB36A3,0xBE6771D6,0x01DF3C89,0xEBC374AA,0x36B833BF,0xF73C75AC,
-  0xCAB4967D,0x4B706B28,0x13AD8725,0xA8F9C3A0,0xB11B1516,0x3AB32CCD,0x545CBD7B,0x4853B5D7,
-  0xF45D3307,0xDFD5D8DE,0xBA207B13,0xE78A88CB,0xE8AC1BF2,0x1C098672,0x41ECAFBD,0xE71B2B28,
-  0x535D6C91,0x57781852,0x727C2965,0x73C39970,0x733B5B28,0x8B8C4BB6,0x4F603601,0xCF25D076,
-  0xCE9A190F,0xDD1C2465,0x5372D27C,0x5B79804D,0x467FB0CD,0x0FE179F1,0x4ECF4B45,0xFFDD85EB,
-  0x0A2FEDB7,0xF7121E8C,0x655D9FB2,0x95E58A0A,0xAA9711A9,0x1556657C,0x52E21F01,0xE6D0E2DB,
-  0x9A469B6B,0xE89FFBEA,0x3292BBCC,0x1AC36F61,0x1DE6A7CB,0x6289CB04,0x4B641435,0x423E8D40,
-  0x90539AE3,0xEFB827D0,0xED44F48D,0xE140FA59,0x92BBBE43,0x025F3C0D,0x8A4E8CE1,0x23C626AD},
-},
-/* BLACK pieces */
-{
- /* EMPTY */
- {0},
- /* PAWN */
- {0x73371D1D,0xB24F8653,0xEC097455,0x23A89F6D,0x98DA1AE7,0x89B1CAE7,0xB1956427,0x819C6F40,
-  0xB3AC2AA6,0xC672D743,0x7B12A8E7,0x6E040148,0x487F96AD,0x5F24951E,0x31323CB0,0x69E71BFE,
-  0xC14AB130,0x31231F30,0x502A9B62,0x47B55E3C,0x1719B3EF,0xBA4FAE42,0x3FFEFEB0,0x4BDE1E6A,
-  0x4A7F316E,0x240D6C44,0x37CD9127,0x79096B73,0x6EDC03BA,0x66A1BEF3,0x9645B334,0xD620BB7C,
-  0x4DFECA51,0xC000786B,0x3C09D0D0,0x0650F06B,0x9156193D,0x6F837370,0x076D996B,0x7D504C14,
-  0x4887843B,0x6C656F7D,0x60797DC5,0x47BC73EE,0x81424278,0x32FDB8E9,0xBB682FAB,0x2968E636,
-  0x18C2F912,0xB66EFAEF,0x767080A7,0xD9D7E76F,0x49F9C3E2,0x9F6948D7,0x2B127D5E,0x36483808,
-  0x61FF4111,0x79B34BC9,0xB40E5EC4,0x2DEE5809,0x5056C619,0x6A296BA2,0x47948187,0x68F51F20,
-  0x520ACDDD,0x9B5DF489,0x7CC071D0,0x3382CE99,0x6654FB82,0x7EED4A43,0x7674FB2D,0xF9F4402C,
-  0x3F458553,0xFB614F83,0xEB29C7FC,0x12949B5E,0x6D2227E2,0x55712E6B,0x7E711BDB,0x3A83155A,
-  0xEE74FA51,0x68E64123,0xE444E082,0x555BEE12,0x095F1526,0x472E233A,0x8A40192C,0xA82023E6,
-  0xC46F756E,0x5C58BF8E,0x63F158CF,0x6F4A3374,0x569FDE64,0x631D46FA,0xA62A57EC,0xDA04F607,
-  0xA9850D3F,0x4C60B754,0x46F00C79,0x8AA2A389,0xCE850BF3,0xE919C7B2,0x044C7754,0x480DC6F4,
-  0x8821600E,0x0020FB27,0x8B4D9AD1,0x547F6633,0x42CD694C,0xBC02143B,0x1FA3AA1E,0x5D33F432,
-  0x4E3E090C,0xA1EE3195,0xD8B8C99D,0x0C39162D,0x14C2AA13,0xF546367E,0x98207714,0x46372CA1,
-  0x188868C4,0x440943D6,0x73ED8B3C,0xEB88CC6A,0xF74A77D5,0x4AB0C0B3,0x66C92829,0xB7DAF761},
- /* KNIGHT */
- {0x25C2829B,0x3835D6AE,0xD6A8B0D2,0x080240E4,0x76C40A63,0x76C554E9,0x90C051F8,0xCD9D7458,
-  0x61D96C36,0x54F60824,0x55C7F54A,0xA1B3FBD0,0xD887D1B3,0x3C5F7778,0x5C53A62F,0x2728CFAE,
-  0xD0E5DEF4,0xAF15B9B4,0x3604B937,0xDB9B2B87,0xF88DA4B2,0xE02FD506,0xF9AAB931,0xC52A1970,
-  0xB477D11F,0x92B7FC8B,0x5324612E,0xF230C513,0xFAC232F7,0xD3B1B0E1,0x4D6FAE3A,0xC98BA369,
-  0xAD8A012D,0x5B644930,0x290D71E6,0xF7ACCA66,0xA04DB70D,0xBDA0FFA9,0x4A58BD11,0x5DCB3F89,
-  0x73129D41,0x7BE4AA7B,0xCA3E110B,0x4A372079,0x68386C35,0xAB72AD36,0x09454104,0xFFB22DD7,
-  0x83059FAC,0xA1117FC1,0x4987E0E1,0x20DECB82,0x0932AEFC,0xE79991C7,0x9026172C,0xA111406E,
-  0x9B93521C,0x98C70749,0xA94E4F72,0xCE7CBAA5,0x7BA9EFC9,0x4C9561D2,0x2787BE01,0x63E45821,
-  0x1C10AD66,0xA7D8980A,0xA291F32A,0x2C8A4017,0x07743497,0xCFEE2F0D,0x8A43280E,0x9FF04416,
-  0x2832D019,0xD51887E3,0x1102CEF8,0xC15FE791,0x314E6565,0x5516CD0A,0x9CA5505F,0xCED80ECC,
-  0x749988FF,0xBEAA9545,0xC8FBF9F7,0xBCBB7BBA,0x07EF3357,0x55563A0F,0x15DCF556,0x32E66429,
-  0x4BF387FB,0x338BDFC8,0x551C43DD,0xCD096408,0xCD98845E,0x0885D389,0x20C7DC33,0x81CBD226,
-  0x6A5B4133,0xB85C72B1,0xAEA33359,0xA2F4D246,0x07F8F8E4,0xE162FF05,0x18EC99FA,0x3A54DC2B,
-  0xAAF971D5,0x3A7E2393,0xB9CA19E8,0xDF57EC8B,0xBF5F97B3,0x2743BD72,0x6F61FCB9,0x4E25A197,
-  0xD0EFF768,0x325A2E17,0x66E6BBCF,0x8C1EC571,0x5059ACBC,0x0333E531,0xDA00887C,0x23EB90B5,
-  0x643168E2,0x963CA116,0x559D59A5,0x585E3F7F,0x2FBAAA5D,0x1F6AC06E,0x8464BE48,0x22392E71},
- /* BISHOP */
- {0xC2D46881,0xD21599AD,0x78589A8B,0x5EB6B044,0xF75BFB85,0x44039F22,0xBAC4C521,0xEBB7A090,
-  0x6CF71226,0xFE6B4838,0x735F5630,0xADC1592A,0x2AAF5D5A,0x1A229354,0xF0E00737,0x637241AA,
-  0x2D24BC1F,0xB1E98801,0x6DF02743,0x23C9C8AF,0xAC68D1B5,0x26020C63,0x6341571D,0x5CDBFD82,
-  0xAB97A158,0x32AB3672,0x8C390741,0xC72D6DD1,0xF23B4ED9,0xE82AAD5B,0xDB5DC9C4,0x14CA89C5,
-  0x49B1276A,0xAD70B9AC,0x3CC23A03,0x3C9A05F5,0x894DB490,0x00B99511,0x03BC7318,0x85CBAA38,
-  0xC1BBDB49,0x6F1B2AA0,0xF4D43A55,0x34244813,0x87BA6A6D,0xFB12A517,0x19084483,0xB6FAEEBE,
-  0x0288D7DE,0x7874B5B4,0x38D752B2,0xA88B96FF,0xE2A5A6C2,0xBF2046F2,0xE54A31B3,0x6A09DE6A,
-  0x5DF754D2,0x5C003AD1,0xC8516354,0x1E9C0333,0x0D2743E1,0x1C97E786,0x146FAAF9,0xB0F98B05,
-  0x8312C06A,0x77426844,0x66FEE747,0xE2CB488E,0xD9CAA212,0x9EDE2B73,0x5D53E06C,0x561A054D,
-  0xF531FEE7,0x444C8F55,0x26374286,0x5493365E,0xE8844BB0,0xAAB1DED1,0xB1D15115,0x61FA9DF9,
-  0x76DF65DF,0x3521FE2D,0x48E2F0BC,0x5B48E530,0xBD646A0B,0xDFB0B1F2,0xD33EB6F4,0x3B2F96D4,
-  0xB5DA160E,0x3471AE62,0xE325F8DC,0x2D7A59AC,0xE89B5355,0x59D950D1,0x8D52BE0C,0x09F0B0C1,
-  0xBACB6AB9,0x77C86CF1,0x7DEA88B7,0x0359A4A7,0x63229BF6,0x96F361C1,0x99E48ABA,0xBD83A035,
-  0x21FA21C3,0x569C8A04,0x8F8324DA,0x2D22285A,0x9306C8F9,0x937EB5D8,0xFF4677BE,0x9148FEF4,
-  0x91D29965,0x41533EB9,0xF239A9C8,0xF32C46CB,0xA40E498A,0x7EA66871,0x4E7D15BE,0xBDDFCBD8,
-  0x14290A50,0xB334CE79,0xED43E573,0xB7532894,0x6913D147,0x87BD5A7A,0xBEA61551,0x0C124098},
- /* ROOK */
- {0x78086460,0xDAD1DAFC,0x74519A14,0xCACA2E0E,0x391F2409,0x4E7062BD,0x8EE639D3,0x48E5E74A,
-  0x29CB35D8,0xB8578CAB,0x48D21E57,0x4C734DAE,0x39DACAF7,0x96EE9805,0xDC25629D,0xBE3943EE,
-  0x522923A9,0x76901814,0x9D496E9A,0xE3D1E9A2,0xC0D57AEE,0x355EB647,0x65072DFE,0x2AF45D4B,
-  0x334A09FF,0xB0812D20,0x8951605C,0x00013382,0xECCFF7CC,0x4CE6C6C3,0x117675DB,0x9E8F6078,
-  0x18DE2D73,0x78E61436,0xEDEE3075,0x5D8CE94A,0x2C997E10,0x945AC3BF,0x869799BB,0xEB5955E9,
-  0xC70D8D98,0x5AF9AA4D,0x58CE719A,0x44BA5727,0x93F93677,0xDA27EDD3,0xDB169DC6,0xB4652E7E,
-  0xF3BF96AD,0x6A417C6F,0x80A98D4C,0x7981C8E3,0x02F5E80E,0xB0AA5C82,0x91419CF2,0x3AA3A82B,
-  0xC4475179,0x50AC80C2,0x721950D0,0x53D6C063,0xC1CBAFBA,0xF2D48B26,0xED6ECE82,0xC5436316,
-  0x6CC5461F,0x3708C559,0xB3CCC723,0x25740404,0x9C97300C,0xD826D107,0x0156C664,0x8C699996,
-  0x27463A8B,0x1BC75831,0x5FC56BA2,0xC3BA8E59,0xA113A335,0xF7AA1E6E,0xA47D2A14,0xAF0D1C8E,
-  0xD7B8BD30,0x948FF3C9,0x42C10642,0x3429A915,0x4C1C8B39,0xB2BCF798,0xB6D6292A,0xB3FC6FC2,
-  0x6D367D13,0xA64BC23E,0xDD68D1F8,0x5B009BBF,0xA5F39815,0x627ABCD3,0x83E26E57,0x705E0663,
-  0x272D4D13,0xF5DB86E1,0xD1C22F90,0xA5C81CD1,0xA1129F8F,0xE5A3DB26,0x97EA0CA1,0x3BCA5269,
-  0xD2A7C91F,0x60E039F5,0xB3E87D12,0x5457D404,0x9911C2DE,0x93EB5088,0x0612C7FF,0x8A3351A9,
-  0xF3DDE9AE,0x0B91142E,0x386A5259,0xF2807DAC,0x01EF7853,0xFAD5B546,0xFFBF98E2,0xAABA27B0,
-  0x83FA25CC,0x12E2702C,0x261D081C,0x9ACB391C,0x90FED423,0xAADE13AA,0x0D16E9CC,0x80A8D337},
- /* QUEEN */
- {0xE0896271,0x739BAF34,0x676201AA,0xF4DB7305,0x0CA94524,0x18539F6F,0x92BCF489,0xF0CBAA28,
-  0x48691EDE,0x1F229C21,0x7AC232A2,0xE3CE4B78,0xEC8214E9,0xE600795A,0x470E9124,0x5EC08888,
-  0x90918FD3,0xD7258BB3,0x1F7AA659,0x1A355FB2,0x784DE213,0x07ED636D,0xD8D5036F,0x62542720,
-  0xAF61C0DE,0xD9B45B06,0x9DA363B6,0xA3CF59DB,0x7EA48FE1,0xE5077E81,0xC1E4F007,0xE9D73094,
-  0x36FEC680,0xC47E6146,0xE903FBE8,0x3E80BDF1,0xF7B9F35F,0x14011012,0x87D71DF5,0x8E31D684,
-  0x5CBD5081,0x2A4E3298,0x7033AE88,0xDB49BBB5,0x5EFCA09F,0xD27A46F6,0x72B4F159,0xF08854D1,
-  0x2ACF4FBA,0x4CA9CA21,0x8B9DECCE,0x09500C8A,0xCE1E734F,0x18A0DFE4,0xB89CC134,0x71BDEA1C,
-  0x77B80F43,0x5E2EF09E,0x2D83D779,0xF4461B88,0x952FFA0C,0x1C208A2B,0xD70C3159,0x42B3FAD7,
-  0xA3C6244A,0xB53EDE1A,0xAB1A7DE6,0xFEB13F0B,0x57E8F841,0xC3D05C13,0x55BAD4A1,0x0EDF2D2A,
-  0xA5E3DF8A,0x84A6EB97,0x60FA35AB,0xCA111403,0x2355D69C,0x358899BD,0x26ED96B6,0x167621F8,
-  0xDAB0E6BA,0x007F0320,0x4027D06F,0x799EF216,0x76367B6D,0xB72EFC3F,0xD7ED97F5,0x64391650,
-  0x64A72F55,0xCF453A8B,0xBDC4B5EE,0x10760288,0x731FE627,0xE094AF9A,0x52C7D0CF,0x7971226B,
-  0xD963FC6B,0x024739DD,0x72CDBF87,0xFB273872,0x774BA480,0x9FD29A82,0x6889CCF0,0xF2F1D449,
-  0x437CB728,0x39DCD3BA,0x7D6DAB6C,0x40822EF5,0xC819FF3C,0xDF13701E,0x0A175E19,0x816AC57A,
-  0x77CC9064,0x9366A326,0x1BA4608A,0x19E23B73,0xC08D145F,0x634630F1,0x9354BBD0,0xAD858695,
-  0xFB2D363D,0x2EE9999D,0x3843918B,0x14A9EEDE,0x805E75BC,0x38E2BC07,0xEF8C1C2B,0x8A152302},
- /* KING */
- {0xFFFB3FB8,0xEB5681AE,0x2DFC6A45,0xE2FD35E6,0x92D22FDA,0x12F806D7,0x39C4F356,0xD09D59E0,
-  0x4F8AE361,0xADF9BD43,0x914E48FD,0x1BEF42AF,0xB04AE2C5,0x687A6AEC,0xF6B501DE,0xD2F50323,
-  0xA465EEB6,0x6A5C2AFD,0x7A8FEDB2,0x8E9ECF51,0x562EE33C,0xFD96A712,0x93AE5E81,0x625A3FA8,
-  0x791E1894,0xAA9EA161,0x38EA6CB0,0xB5E9A14F,0x64289701,0xD1B904C0,0x4359AB76,0xE05090CD,
-  0x3AC15AD0,0x1EB70560,0xF7CB16F0,0xBF34FF2D,0x6C20D01C,0xB13E4D9B,0x5124675D,0xC3BBD2F0,
-  0x004E048F,0x3AA8A0B8,0xCDD52989,0xB34BA2C7,0x91CB8A26,0xB16F00B9,0xC1DD690E,0x32F19EA2,
-  0x4AEE18D9,0xB3A0F5DA,0x15FFBA07,0xABF7F6E8,0xD3D534E3,0x24F74097,0x364A77AC,0x2D7BA3E8,
-  0x2E401CCA,0xC4A253E5,0x7F6F9A92,0x0355505E,0x8D3BEDF0,0x3A015BC1,0x3CBF732D,0xEEC09B3F,
-  0xF7DFF0B7,0x859E47C1,0x7B48A804,0x1A1EB5A7,0xC7E88F55,0x444AAF65,0x4BA35A3C,0x4CA03B99,
-  0x3D06480A,0x6256BD17,0x7B0BAAC3,0x2DAD96B5,0xC061938B,0x49B1B07E,0x8683743B,0xEB961850,
-  0x1A65E484,0xCE49AA4B,0x134D8A6F,0xEA46B228,0x5A1283B4,0x3B055861,0x9BD39043,0xD5AEEDC0,
-  0x46AE8E0F,0x267B7212,0x54833DE1,0xD7E3D1F5,0xA6352C44,0x181BACE6,0xC5A782F8,0x1D9C2FB3,
-  0x6B4D83F0,0x72831079,0x9A7BE29B,0x6F8DABA8,0x84742BD1,0x9E6F5267,0x40D45CD9,0x418E589E,
-  0x0AEDD2E3,0xF894A169,0x369815B1,0x4E98CEE8,0x9180260F,0x58553343,0x2BF411FD,0x10A136D4,
-  0x00DF7135,0x037E9E84,0xEAF768BE,0xC287E43F,0x47515F02,0xE432D26F,0xF4297F23,0x32268FE0,
-  0xE69FE4B4,0x7EDAF631,0xAF9745C7,0x1679AC98,0x7ACF2366,0x087EF29C,0x28620102,0xC3C5449F},
-}
-};
+u64 zobrist_pieces[2][7][128];
+u64 zobrist_side;
+u64 zobrist_castle[16];
+u64 zobrist_ep[8];
 
-const u32 zobrist_side = 0xC32E573A;
+/* splitmix64: fixed seed, so keys (and TT behaviour) are reproducible */
+static u64 zobrist_seed = 0x9E3779B97F4A7C15ULL;
 
-const u32 zobrist_castle[16] = {
-    0xBF244D25, 0x6F80E7F1, 0xA221FFF6, 0x4BCAD56D,
-    0x02B52321, 0x68446594, 0xE77809EE, 0x73363905,
-    0x0B3C5DFC, 0x61E10136, 0x829085A0, 0x7838100A,
-    0xDAA1F795, 0xA4E3D953, 0x4EEA807D, 0x86F22460
-};
+static u64 zobrist_rand(void) {
+    u64 z = (zobrist_seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-const u32 zobrist_ep[8] = {
-    0x769ED188, 0x63474AA4, 0x498EDD65, 0x5869B731,
-    0x05FAD954, 0xE553BF37, 0x0716408F, 0x6E0AB88F
-};
+static void init_zobrist(void) {
+    u8 c, pt, i;
+    u16 sq;
+
+    for (c = 0; c < 2; c++)
+        for (pt = 0; pt < 7; pt++)
+            for (sq = 0; sq < 128; sq++)
+                zobrist_pieces[c][pt][sq] = zobrist_rand();
+    zobrist_side = zobrist_rand();
+    /* Castle keys are indexed by the whole rights mask; keep "none" at 0 */
+    zobrist_castle[0] = 0;
+    for (i = 1; i < 16; i++) zobrist_castle[i] = zobrist_rand();
+    for (i = 0; i < 8; i++) zobrist_ep[i] = zobrist_rand();
+}
 
 #endif /* TARGET_C64 */
 
@@ -590,11 +390,24 @@ const u8 mvv_lva[7][7] = {
     /* king  */  { 0,    0,    0,     0,    0,     0,    0 }
 };
 
+/* MF_* flags of each 4-bit move code (see Move in types.h); the unused
+ * codes 3, 6 and 7 decode to MF_INVALID */
+const u8 move_code_flags[16] = {
+    MF_NONE, MF_PAWNSTART, MF_CASTLE, MF_INVALID,
+    MF_CAPTURE, MF_CAPTURE | MF_EP, MF_INVALID, MF_INVALID,
+    MF_PROMO_N, MF_PROMO_B, MF_PROMO_R, MF_PROMO_Q,
+    MF_CAPTURE | MF_PROMO_N, MF_CAPTURE | MF_PROMO_B,
+    MF_CAPTURE | MF_PROMO_R, MF_CAPTURE | MF_PROMO_Q
+};
+
 /* Knight move offsets (8 directions on 0x88 board) */
 const s8 knight_offsets[8] = {
     -33, -31, -18, -14, 14, 18, 31, 33
 };
 
+/* King move offsets (opposite directions mirror around the middle) */
+const s8 king_offsets[8] = { -17, -16, -15, -1, 1, 15, 16, 17 };
+
 /* Bishop move direction offsets */
 const s8 bishop_offsets[4] = { -17, -15, 15, 17 };
 
@@ -619,6 +432,130 @@ const u8 castle_mask[128] = {
     0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF  /* off-board */
 };
 
+u8 attack_table[240];
+s8 delta_table[240];
+
+static void init_attack_tables(void) {
+    u8 i, k, idx;
+    s8 dir;
+
+    /* A piece on 'from' attacks 'to' = from + offset, so the table index
+     * is 119 - offset and the step from 'to' back to 'from' is -dir. */
+    for (i = 0; i < 8; i++) {
+        attack_table[119 - knight_offsets[i]] |= ATK_KNIGHT;
+        attack_table[119 - king_offsets[i]] |= ATK_KING;
+        delta_table[119 - king_offsets[i]] = (s8)-king_offsets[i];
+    }
+
+    for (i = 0; i < 4; i++) {
+        for (k = 1; k < 8; k++) {
+            dir = bishop_offsets[i];
+            idx = (u8)(119 - k * dir);
+            attack_table[idx] |= ATK_BISHOP | ATK_QUEEN;
+            delta_table[idx] = (s8)-dir;
+
+            dir = rook_offsets[i];
+            idx = (u8)(119 - k * dir);
+            attack_table[idx] |= ATK_ROOK | ATK_QUEEN;
+            delta_table[idx] = (s8)-dir;
+        }
+    }
+
+    /* White pawns capture towards +15/+17, black pawns towards -15/-17 */
+    attack_table[119 - 15] |= ATK_WPAWN;
+    attack_table[119 - 17] |= ATK_WPAWN;
+    attack_table[119 + 15] |= ATK_BPAWN;
+    attack_table[119 + 17] |= ATK_BPAWN;
+}
+
+#ifndef TARGET_C64
+HashKey cuckoo_keys[CUCKOO_SIZE];
+u8 cuckoo_sq1[CUCKOO_SIZE];
+u8 cuckoo_sq2[CUCKOO_SIZE];
+
+/* attack_table bit for each non-pawn piece type */
+static const u8 piece_atk_bit[7] = {
+    0, 0, ATK_KNIGHT, ATK_BISHOP, ATK_ROOK, ATK_QUEEN, ATK_KING
+};
+
+/* Needs the Zobrist keys and attack_table */
+static void init_cuckoo(void) {
+    u8 c, pt, s1, s2, sq1, sq2, tmp;
+    u16 i;
+    HashKey key, tmp_key;
+
+    for (i = 0; i < CUCKOO_SIZE; i++) {
+        cuckoo_keys[i] = 0;
+        cuckoo_sq1[i] = 0;
+        cuckoo_sq2[i] = 0;
+    }
+
+    for (c = 0; c < 2; c++) {
+        for (pt = KNIGHT; pt <= KING; pt++) {
+            for (s1 = 0; s1 < 64; s1++) {
+                for (s2 = s1 + 1; s2 < 64; s2++) {
+                    sq1 = SQ_FROM64(s1);
+                    sq2 = SQ_FROM64(s2);
+                    if (!(attack_table[ATTACK_INDEX(sq1, sq2)] & piece_atk_bit[pt]))
+                        continue;
+
+                    key = zobrist_pieces[c][pt][sq1] ^
+                          zobrist_pieces[c][pt][sq2] ^ zobrist_side;
+
+                    /* Cuckoo insertion: evict whatever sits in the slot
+                     * and move it to its other slot until one is free */
+                    i = CUCKOO_H1(key);
+                    for (;;) {
+                        tmp_key = cuckoo_keys[i];
+                        cuckoo_keys[i] = key;
+                        key = tmp_key;
+                        tmp = cuckoo_sq1[i]; cuckoo_sq1[i] = sq1; sq1 = tmp;
+                        tmp = cuckoo_sq2[i]; cuckoo_sq2[i] = sq2; sq2 = tmp;
+                        if (key == 0) break;
+                        i = (i == CUCKOO_H1(key)) ? CUCKOO_H2(key) : CUCKOO_H1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+#endif
+
+u8 lmr_table[LMR_MAX][LMR_MAX];
+
+/* log2(x) in 1/64ths, x >= 1: the integer part from the top bit, the
+ * fraction linear between powers of two (at most 0.09 low) */
+static u16 log2_fx(u8 x) {
+    u8 n = 0;
+    while ((x >> n) > 1) n++;
+    return (u16)(n * 64 + (((u16)x << 6) >> n) - 64);
+}
+
+/* ln(d) ln(m) / 2.25 = log2(d) log2(m) * 0.2136. With the logs in 1/64ths
+ * their product is in 1/4096ths, and 0.2136 is about 875/4096. */
+static void init_lmr(void) {
+    u8 d, m;
+    u32 r;
+
+    for (d = 1; d < LMR_MAX; d++) {
+        for (m = 1; m < LMR_MAX; m++) {
+            r = (u32)log2_fx(d) * log2_fx(m) * 875 / 4096;
+            lmr_table[d][m] = (u8)((r + 3072) / 4096);    /* + 0.75 */
+        }
+    }
+}
+
 void tables_init(void) {
-    /* All tables are const/hardcoded - nothing to initialize at runtime */
+    /* The tables above are const; the 0x88 attack/delta tables, the LMR
+     * table, the PC Zobrist keys, cuckoo table and bitboard attack tables
+     * are built at runtime */
+    init_attack_tables();
+    init_lmr();
+#ifndef TARGET_C64
+    init_zobrist();
+    init_cuckoo();
+#endif
+#ifdef USE_BITBOARDS
+    bitboard_init();
+#endif
 }
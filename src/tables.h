@@ -29,17 +29,18 @@ extern const s8 pst_king_eg[64];   /* endgame king table */
 /* Array of PST pointers indexed by piece type (0=NULL, 1=pawn, ..., 6=king_mg) */
 extern const s8 *pst_table[7];
 
-/* Zobrist random numbers - 16-bit on C64, 32-bit on PC */
+/* Zobrist random numbers - 16-bit constants on C64, 64-bit on PC
+ * (generated by tables_init from a fixed seed) */
 #ifdef TARGET_C64
 extern const u16 zobrist_pieces[2][7][128];  /* [color][piece_type][sq88] */
 extern const u16 zobrist_side;               /* XOR when black to move */
 extern const u16 zobrist_castle[16];         /* indexed by castle rights */
 extern const u16 zobrist_ep[8];              /* indexed by file */
 #else
-extern const u32 zobrist_pieces[2][7][128];
-extern const u32 zobrist_side;
-extern const u32 zobrist_castle[16];
-extern const u32 zobrist_ep[8];
+extern u64 zobrist_pieces[2][7][128];
+extern u64 zobrist_side;
+extern u64 zobrist_castle[16];
+extern u64 zobrist_ep[8];
 #endif
 
 /* MVV-LVA table: [victim_type][attacker_type] -> score */
@@ -48,14 +49,58 @@ extern const u8 mvv_lva[7][7];
 /* Knight move offsets */
 extern const s8 knight_offsets[8];
 
+/* King move offsets, also the eight queen directions. Ordered so that
+ * index 7 - i is the opposite direction of index i. */
+extern const s8 king_offsets[8];
+
 /* Bishop/Rook/Queen direction offsets */
 extern const s8 bishop_offsets[4];
 extern const s8 rook_offsets[4];
 
+/* 0x88 attack lookup, indexed by ATTACK_INDEX(from, to) (0..238).
+ * attack_table says which pieces standing on 'from' could attack 'to' on
+ * an empty board; delta_table gives the ray step that walks from 'to'
+ * back towards 'from' (0 if the squares share no line).
+ * Only the square difference matters, which is what makes 0x88 work. */
+#define ATTACK_INDEX(from, to) ((u8)((from) - (to) + 119))
+
+#define ATK_WPAWN   0x01
+#define ATK_BPAWN   0x02
+#define ATK_KNIGHT  0x04
+#define ATK_BISHOP  0x08
+#define ATK_ROOK    0x10
+#define ATK_QUEEN   0x20
+#define ATK_KING    0x40
+
+extern u8 attack_table[240];
+extern s8 delta_table[240];
+
+#ifndef TARGET_C64
+/* Cuckoo table of reversible moves for upcoming-repetition detection
+ * (board_has_game_cycle). Every non-pawn move between two squares on an
+ * empty board is stored once, keyed by the hash difference it makes
+ * (both piece keys plus zobrist_side); A->B and B->A share the entry.
+ * PC only: 3668 moves need an 8192-entry table, far beyond the C64. */
+#define CUCKOO_SIZE   8192
+#define CUCKOO_H1(k)  ((u16)((k) & 0x1FFF))
+#define CUCKOO_H2(k)  ((u16)(((k) >> 16) & 0x1FFF))
+
+extern HashKey cuckoo_keys[CUCKOO_SIZE];
+extern u8 cuckoo_sq1[CUCKOO_SIZE];     /* 0x88 squares of the move */
+extern u8 cuckoo_sq2[CUCKOO_SIZE];
+#endif
+
+/* Late move reductions in plies by [depth][move number], both clamped to
+ * LMR_MAX - 1: about 0.75 + ln(depth) * ln(moves) / 2.25, worked out
+ * with integer logarithms (no floating point on the C64) */
+#define LMR_MAX 32
+extern u8 lmr_table[LMR_MAX][LMR_MAX];
+
 /* Castling rights update table: indexed by 0x88 square
  * castle_rights &= castle_mask[from] & castle_mask[to] */
 extern const u8 castle_mask[128];
 
+/* Build the runtime tables (attack/delta tables, PC bitboards) */
 void tables_init(void);
 
 #endif /* TABLES_H */
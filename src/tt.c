@@ -2,7 +2,8 @@
 
 /*
  * On C64: place TT in the TTABLE segment at $C000 (banked-out BASIC ROM).
- * On PC: just a regular static array.
+ * On PC: a regular static array, used by engines without a table of
+ * their own (Engine.tt == NULL).
  */
 #ifdef TARGET_C64
 #pragma bss-name("TTABLE")
@@ -14,9 +15,23 @@ static TTEntry tt_table[TT_SIZE];
 #pragma bss-name(push, "BSS")
 #endif
 
-/* Get TT index from hash */
-static u16 tt_index(HashKey hash) {
-    return (u16)(hash & (TT_SIZE - 1));  /* TT_SIZE must be power of 2 */
+/* The current engine's table */
+#ifdef TARGET_C64
+#define TT_TABLE tt_table
+#else
+#define TT_TABLE (g_engine->tt ? g_engine->tt : tt_table)
+#endif
+
+/* TT slot index: u16 is enough for the C64's 512 entries */
+#ifdef TARGET_C64
+typedef u16 TTIndex;
+#else
+typedef u32 TTIndex;
+#endif
+
+/* Get TT index from the low bits of the hash */
+static TTIndex tt_index(HashKey hash) {
+    return (TTIndex)(hash & (TT_SIZE - 1));  /* TT_SIZE must be power of 2 */
 }
 
 /* Adjust mate scores for storage (make them relative to root, not ply) */
@@ -33,83 +48,84 @@ static s16 score_from_tt(s16 score, u8 ply) {
 }
 
 void tt_clear(void) {
+    TTEntry *table = TT_TABLE;
     u32 i;
     for (i = 0; i < TT_SIZE; i++) {
-        tt_table[i].key = 0;
-        tt_table[i].score = 0;
-        tt_table[i].best.from = 0;
-        tt_table[i].best.to = 0;
-        tt_table[i].best.flags = 0;
-        tt_table[i].best.score = 0;
-        tt_table[i].depth = 0;
+        table[i].key = 0;
+        table[i].score = 0;
+        table[i].best = MOVE_NONE;
+        table[i].depth = 0;
     }
 }
 
-u8 tt_probe(HashKey hash, u8 depth, s16 alpha, s16 beta,
-            s16 *score, Move *best_move, u8 search_ply) {
-    u16 idx = tt_index(hash);
-    TTEntry *entry = &tt_table[idx];
-    u8 tt_depth, tt_flag;
+u8 tt_probe_entry(HashKey hash, u8 search_ply, TTHit *hit) {
+    TTIndex idx = tt_index(hash);
+    TTEntry *entry = &TT_TABLE[idx];
 
     /* Check key match */
     if (entry->key != TT_KEY(hash)) return 0;
 
-    /* Always extract best move if available */
-    if (best_move) {
-        *best_move = entry->best;
-    }
-
-    /* Check depth */
-    tt_depth = entry->depth & 0x3F;  /* lower 6 bits = depth */
-    tt_flag = (entry->depth >> 6) & 0x03; /* upper 2 bits = flag */
-
-    if (tt_depth < depth) return 0;
+    hit->best_move = entry->best;
+    hit->score = score_from_tt(entry->score, search_ply);
+    hit->depth = entry->depth & 0x3F;          /* lower 6 bits = depth */
+    hit->flag = (entry->depth >> 6) & 0x03;    /* upper 2 bits = flag */
+    return 1;
+}
 
-    /* Adjust score for mate distance */
-    {
-        s16 tt_score = score_from_tt(entry->score, search_ply);
+u8 tt_cutoff(const TTHit *hit, u8 depth, s16 alpha, s16 beta, s16 *score) {
+    if (hit->depth < depth) return 0;
 
-        switch (tt_flag) {
-            case TT_FLAG_EXACT:
-                *score = tt_score;
+    switch (hit->flag) {
+        case TT_FLAG_EXACT:
+            *score = hit->score;
+            return 1;
+        case TT_FLAG_ALPHA:
+            if (hit->score <= alpha) {
+                *score = alpha;
                 return 1;
-            case TT_FLAG_ALPHA:
-                if (tt_score <= alpha) {
-                    *score = alpha;
-                    return 1;
-                }
-                break;
-            case TT_FLAG_BETA:
-                if (tt_score >= beta) {
-                    *score = beta;
-                    return 1;
-                }
-                break;
-        }
+            }
+            break;
+        case TT_FLAG_BETA:
+            if (hit->score >= beta) {
+                *score = beta;
+                return 1;
+            }
+            break;
     }
-
     return 0;
 }
 
+u8 tt_probe(HashKey hash, u8 depth, s16 alpha, s16 beta,
+            s16 *score, Move *best_move, u8 search_ply) {
+    TTHit hit;
+
+    if (!tt_probe_entry(hash, search_ply, &hit)) return 0;
+
+    /* Always extract best move if available */
+    if (best_move) {
+        *best_move = hit.best_move;
+    }
+    return tt_cutoff(&hit, depth, alpha, beta, score);
+}
+
 void tt_store(HashKey hash, u8 depth, s16 score, u8 flag,
               Move best_move, u8 search_ply) {
-    u16 idx = tt_index(hash);
-    TTEntry *entry = &tt_table[idx];
+    TTIndex idx = tt_index(hash);
+    TTEntry *entry = &TT_TABLE[idx];
 
     /* Always-replace scheme (simple, works well with small TT) */
     entry->key = TT_KEY(hash);
     entry->score = score_to_tt(score, search_ply);
     entry->best = best_move;
-    entry->best.score = 0; /* don't store move ordering score */
     entry->depth = (u8)((depth & 0x3F) | (flag << 6));
 }
 
 u8 tt_probe_move(HashKey hash, Move *best_move) {
-    u16 idx = tt_index(hash);
-    TTEntry *entry = &tt_table[idx];
+    TTIndex idx = tt_index(hash);
+    TTEntry *entry = &TT_TABLE[idx];
 
     if (entry->key != TT_KEY(hash)) return 0;
-    if (entry->best.from == 0 && entry->best.to == 0) return 0;
+    if (IS_MOVE_NONE(entry->best)) return 0;
 
     *best_move = entry->best;
     return 1;
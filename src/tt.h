@@ -5,17 +5,32 @@
 
 /*
  * Transposition Table
- * 512 entries x 8 bytes = 4KB
+ * 512 entries x 7 bytes = 3.5KB
  * On C64: mapped to $C000 via custom linker segment
- * On PC: normal static array
+ * On PC: normal static array, unless the current engine has a table of
+ * its own or shares another engine's (engine.h)
  */
 
 /* Initialize/clear the transposition table */
 void tt_clear(void);
 
-/* Probe the TT for the current position.
- * Returns 1 if hit found, fills score/best_move/depth/flag.
- * Adjusts mate scores for ply distance. */
+/* What the TT holds for a position */
+typedef struct {
+    Move best_move;    /* MOVE_NONE if none */
+    s16  score;        /* stored score, mate scores adjusted to the ply */
+    u8   depth;        /* depth it was searched to */
+    u8   flag;         /* bound: TT_FLAG_EXACT, TT_FLAG_ALPHA or TT_FLAG_BETA */
+} TTHit;
+
+/* Look up a position at any depth. Returns 1 and fills hit if found. */
+u8 tt_probe_entry(HashKey hash, u8 search_ply, TTHit *hit);
+
+/* Does hit decide a node searched to depth with window (alpha, beta)?
+ * Returns 1 and sets score (fail-hard: alpha or beta for bounds). */
+u8 tt_cutoff(const TTHit *hit, u8 depth, s16 alpha, s16 beta, s16 *score);
+
+/* Probe the TT for the current position: tt_probe_entry, then tt_cutoff.
+ * Fills best_move (if not NULL) on any hit; returns 1 on a cutoff. */
 u8 tt_probe(HashKey hash, u8 depth, s16 alpha, s16 beta,
             s16 *score, Move *best_move, u8 search_ply);
 
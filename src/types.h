@@ -1,6 +1,8 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stddef.h>
+
 /*
  * C64 Chess Engine - Core Types and Constants
  *
@@ -33,7 +35,27 @@
   typedef int16_t   s16;
   typedef uint32_t  u32;
   typedef int32_t   s32;
-  typedef u32 HashKey;     /* 32-bit hash on PC (far fewer collisions) */
+  typedef uint64_t  u64;
+  typedef u64 HashKey;     /* 64-bit hash on PC (index and verify bits disjoint) */
+#endif
+
+/* Optional incrementally updated attack maps (either backend); define
+ * ATTACK_MAPS to make board_is_square_attacked an O(1) lookup at the cost
+ * of extra work in make/unmake. Off by default - see make bench-maps. */
+
+/* Make/unmake strategy: with COPY_MAKE (PC only) board_make_move saves
+ * the whole position block (everything in GameState before undo_stack)
+ * per ply and board_unmake_move copies it back, instead of writing and
+ * replaying an Undo record. Compare nodes/sec with make bench-copy. */
+#if defined(COPY_MAKE) && defined(TARGET_C64)
+#error "COPY_MAKE needs a per-ply position stack too large for the C64"
+#endif
+
+/* Board backend: the PC build keeps 64-bit bitboards alongside the 0x88
+ * board for attack detection and move generation. The C64 build uses the
+ * 0x88 board alone; define BOARD_0X88_ONLY to test that path on PC. */
+#if !defined(TARGET_C64) && !defined(BOARD_0X88_ONLY)
+#define USE_BITBOARDS
 #endif
 
 /* Boolean */
@@ -84,6 +106,7 @@
 #define SQ_MAKE(r, f)   (((r) << 4) | (f))
 #define SQ_FLIP(sq)     ((sq) ^ 0x70)   /* mirror vertically for black PST */
 #define SQ_INDEX64(sq)  ((SQ_RANK(sq) << 3) | SQ_FILE(sq))  /* 0x88 -> 0..63 */
+#define SQ_FROM64(s)    ((s) + ((s) & 0x38))                 /* 0..63 -> 0x88 */
 
 /* Named squares */
 #define SQ_A1 0x00
@@ -122,6 +145,7 @@
 #define MF_EP       0x04   /* en passant capture */
 #define MF_PAWNSTART 0x08  /* double pawn push */
 #define MF_PROMO    0x10   /* promotion (promo piece in bits 5-6) */
+#define MF_INVALID  0x80   /* unused move code: never a legal move */
 
 /* Promotion piece encoding in flags bits 5-6 */
 #define MF_PROMO_N  (MF_PROMO | (0 << 5))
@@ -130,18 +154,29 @@
 #define MF_PROMO_Q  (MF_PROMO | (3 << 5))
 #define PROMO_TYPE(flags) (KNIGHT + (((flags) >> 5) & 3))
 
-/* Move structure - 4 bytes, fits well on 6502 */
-typedef struct {
-    u8 from;      /* source square (0x88) */
-    u8 to;        /* target square (0x88) */
-    u8 flags;     /* move flags */
-    u8 score;     /* move ordering score */
-} Move;
+/* Move - 16 bits: from square (bits 0-5) and to square (bits 6-11) as
+ * 0..63 indices, and a 4-bit move code (bits 12-15) standing for the MF_*
+ * flags above. Ordering scores live apart in g_state.move_score.
+ *   code 0 quiet, 1 double push, 2 castle, 4 capture, 5 en passant,
+ *   8-11 promotion to N/B/R/Q, 12-15 capture-promotion to N/B/R/Q */
+typedef u16 Move;
+
+#define MOVE_CODE(f) \
+    (((f) & MF_PROMO) ? (8 | (((f) & MF_CAPTURE) << 2) | (((f) >> 5) & 3)) : \
+     ((f) & MF_EP) ? 5 : ((f) & MF_CAPTURE) ? 4 : \
+     ((f) & MF_CASTLE) ? 2 : ((f) & MF_PAWNSTART) ? 1 : 0)
+
+#define MOVE_PACK(from, to, f) \
+    ((Move)(SQ_INDEX64(from) | (SQ_INDEX64(to) << 6) | (MOVE_CODE(f) << 12)))
+#define MOVE_FROM(m)  ((u8)SQ_FROM64((m) & 0x3F))         /* 0x88 square */
+#define MOVE_TO(m)    ((u8)SQ_FROM64(((m) >> 6) & 0x3F))  /* 0x88 square */
+#define MOVE_FLAGS(m) (move_code_flags[(m) >> 12])        /* MF_* flags */
+
+extern const u8 move_code_flags[16];
 
-/* Move is "null" if from == to == 0 */
-#define MOVE_NONE_FROM 0
-#define MOVE_NONE_TO   0
-#define IS_MOVE_NONE(m) ((m).from == MOVE_NONE_FROM && (m).to == MOVE_NONE_TO)
+/* Move is "null" if from == to == 0 (a1a1, never generated) */
+#define MOVE_NONE 0
+#define IS_MOVE_NONE(m) ((m) == MOVE_NONE)
 
 /* Castling rights (bitmask) */
 #define CASTLE_WK 0x01  /* White kingside */
@@ -163,59 +198,108 @@ typedef struct {
 #define MAX_MOVES   256   /* max moves per position (generous) */
 #define MAX_GAME_MOVES 512
 
+/* Piece-to keys of quiet move statistics: 12 pieces x 64 targets */
+#define PIECE_TO_COUNT 768
+#define PIECE_TO_NONE  0xFFFF    /* null move, or no move yet */
+
 /* Undo information for unmake_move */
 typedef struct {
     u8  captured;      /* captured piece (or EMPTY) */
     u8  castle_rights; /* castling rights before move */
     u8  ep_square;     /* en passant square before move */
     u8  fifty_clock;   /* fifty-move counter before move */
+    u8  plies_from_null; /* plies since a null move, before move */
     HashKey hash;      /* Zobrist hash before move */
+    HashKey pawn_hash; /* pawn key before move */
+    HashKey material_hash; /* material signature before move */
     s16 material[2];   /* material scores before move */
     s16 pst_score[2];  /* piece-square scores before move */
+    u8  cap_slot;      /* piece list slot the captured piece occupied */
+    u8  promo_slot;    /* piece list slot the promoting pawn occupied */
 } Undo;
 
-/* Transposition table entry - 8 bytes */
+/* Transposition table entry - 7 bytes on C64, 12 on PC */
 #define TT_FLAG_EXACT  0
 #define TT_FLAG_ALPHA  1   /* upper bound (fail-low) */
 #define TT_FLAG_BETA   2   /* lower bound (fail-high) */
 
+#ifdef TARGET_C64
+typedef u16 TTKey;
+#else
+typedef u32 TTKey;
+#endif
+
 typedef struct {
-    u16 key;       /* verification key (upper bits of Zobrist hash) */
+    TTKey key;     /* verification key (see TT_KEY) */
     s16 score;     /* evaluation score */
-    Move best;     /* best move (from, to, flags - score field unused) */
+    Move best;     /* best move (MOVE_NONE if none) */
     u8  depth;     /* search depth (lower 6 bits) + flag (upper 2 bits) */
 } TTEntry;
 
 #ifdef TARGET_C64
-#define TT_SIZE 512        /* 4KB on C64 */
+#define TT_SIZE 512        /* 3.5KB on C64 */
 #define TT_KEY(h) ((u16)(h))
 #else
-#define TT_SIZE 65536      /* 512KB on PC - ample room */
-#define TT_KEY(h) ((u16)((h) >> 16))
+#define TT_SIZE 65536      /* 768KB on PC - ample room */
+/* Index comes from the low bits, the key from the high 32: the two never
+ * overlap for any TT_SIZE up to 2^32 entries */
+#define TT_KEY(h) ((u32)((h) >> 32))
 #endif
 
+/* Piece list capacity per [color][piece type]: 8 pawns, or 2 originals
+ * plus 8 promoted pieces */
+#define MAX_PIECE_SLOTS 10
+
 /* Flat move buffer - shared across all plies */
 #define MOVE_BUF_SIZE 4096
 
-/* Global game/board state - declared in board.c */
+/* Global game/board state - declared in board.c
+ * Position fields come first, up to undo_stack: COPY_MAKE copies exactly
+ * that prefix (POSITION_BYTES). */
 typedef struct {
     u8  board[128];       /* 0x88 board */
     u8  side;             /* side to move (WHITE/BLACK) */
     u8  castle_rights;    /* castling rights bitmask */
     u8  ep_square;        /* en passant target square (SQ_NONE if none) */
     u8  fifty_clock;      /* fifty-move rule counter */
+    u8  plies_from_null;  /* plies since the last null move (stops at 255) */
     u16 ply;              /* half-move clock (total) */
-    HashKey hash;          /* Zobrist hash (16-bit C64, 32-bit PC) */
+    HashKey hash;          /* Zobrist hash (16-bit C64, 64-bit PC) */
+    HashKey pawn_hash;     /* Zobrist key of the pawns only */
+    HashKey material_hash; /* key of the piece counts per [color][type] */
     u8  king_sq[2];       /* king squares [WHITE/BLACK] */
     s16 material[2];      /* material score [WHITE/BLACK] */
     s16 pst_score[2];     /* piece-square table score [WHITE/BLACK] */
 
+    /* Piece lists: squares of each [color][piece type], kept in sync by
+     * make/unmake so move generation never scans all 128 squares */
+    u8  piece_list[2][7][MAX_PIECE_SLOTS];
+    u8  piece_count[2][7];
+    u8  piece_index[128]; /* slot of the piece on sq within its list */
+
+#ifdef ATTACK_MAPS
+    /* Attack maps [color][sq]. Bits 0-7 of attackers: the first piece in
+     * direction king_offsets[i] from sq attacks it (slider, king or pawn);
+     * bits 8-15: a knight on sq + knight_offsets[i] attacks it. */
+    u16 attackers[2][128];
+    u8  attack_count[2][128];
+#endif
+
+#ifdef USE_BITBOARDS
+    /* Bitboards mirroring board[] (bit = SQ_INDEX64 square) */
+    u64 bb_pieces[2][7];  /* [color][piece type] */
+    u64 bb_color[2];      /* all pieces of a color */
+    u64 bb_occupied;      /* all pieces */
+#endif
+
     /* Undo stack */
     Undo undo_stack[MAX_GAME_MOVES];
     u16  undo_ply;
 
-    /* Move buffer - flat array shared by all plies */
+    /* Move buffer - flat array shared by all plies, with the ordering
+     * score of each move at the same index */
     Move move_buf[MOVE_BUF_SIZE];
+    s16  move_score[MOVE_BUF_SIZE];
     u16  move_buf_idx[MAX_PLY + 1]; /* start index for each ply */
 
     /* History for repetition detection */
@@ -223,6 +307,91 @@ typedef struct {
     u16 hash_hist_count;
 } GameState;
 
-extern GameState g_state;
+#define POSITION_BYTES offsetof(GameState, undo_stack)
+
+/* Search info (for UCI info output) */
+typedef struct {
+    u32  nodes;
+    u8   max_depth;     /* max depth to search */
+    u32  max_time_ms;   /* max time in milliseconds (0 = no limit) */
+    u32  start_time;    /* search start timestamp */
+    u8   stopped;       /* set to 1 to abort search */
+    u8   use_time;      /* 1 if time control is active */
+#ifndef TARGET_C64
+    /* go searchmoves: the only root moves searched (count 0: all) */
+    u16  root_move_count;
+    Move root_moves[MAX_MOVES];
+#endif
+#ifdef TARGET_TEST
+    /* Test builds: depth the root was last searched to, after its own
+     * reductions, so tests can tell it reached the depth it reports */
+    u8   root_depth;
+#endif
+} SearchInfo;
+
+/* Search result */
+typedef struct {
+    Move best_move;
+    s16  score;
+    u8   depth;
+    u32  nodes;
+} SearchResult;
+
+#ifndef TARGET_C64
+/* Threads of one Lazy SMP search: the engine's own plus its helpers */
+#define SEARCH_MAX_THREADS 64
+#endif
+
+/* Engine context: everything a search writes to, so that one process can
+ * run several engines (see engine.h). The modules reach the current one
+ * through g_engine - on the C64 a single static engine, so g_state is a
+ * plain global there; on PC a thread-local pointer. */
+typedef struct Engine {
+    GameState  state;
+    SearchInfo search_info;
+    u8   pruning_off;                  /* PRUNE_* switched off (search.h) */
+    Move pv_table[MAX_PLY][MAX_PLY];   /* triangular PV table */
+    u8   pv_length[MAX_PLY];
+    Move killers[MAX_PLY][2];          /* 2 killer moves per ply */
+    s16  eval_stack[MAX_PLY];          /* static eval per ply (search.c) */
+    Move excluded[MAX_PLY];            /* move skipped by a singular search */
+#ifndef TARGET_C64
+    /* Quiet move statistics (movesort.c). A piece-to key is the moved
+     * piece (12 kinds) times 64 plus the 0..63 target square. */
+    s16  history[2][64][64];           /* butterfly: [side][from][to] */
+    Move countermoves[PIECE_TO_COUNT]; /* by piece-to of the previous move */
+    s16  cont_history[PIECE_TO_COUNT][PIECE_TO_COUNT];
+    u16  played[MAX_PLY];              /* piece-to of the move made at a ply */
+#endif
+#ifdef COPY_MAKE
+    /* Saved position block per make, indexed by undo_ply */
+    u8   pos_stack[MAX_GAME_MOVES][POSITION_BYTES];
+#endif
+#ifndef TARGET_C64
+    TTEntry *tt;       /* table to probe; NULL for tt.c's built-in one */
+    u8   owns_tt;      /* tt was allocated for this engine */
+
+    /* Lazy SMP (search.c): helper engines that search this engine's root
+     * on threads of their own, sharing its TT */
+    u8   helper_count;
+    struct Engine *helpers[SEARCH_MAX_THREADS - 1];
+    u8   info_off;                /* print no UCI info lines */
+    /* ... and the same engine seen as a helper */
+    u8   helper_id;               /* thread number, 1 and up */
+    SearchResult helper_result;   /* result of its last search */
+    volatile u8 smp_stop;         /* raised when the main search ends */
+#endif
+} Engine;
+
+/* The engine main() and the tests run (declared in engine.c) */
+extern Engine g_engine_main;
+
+#ifdef TARGET_C64
+#define g_engine (&g_engine_main)
+#else
+extern __thread Engine *g_engine;
+#endif
+
+#define g_state (g_engine->state)
 
 #endif /* TYPES_H */
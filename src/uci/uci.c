@@ -7,6 +7,7 @@
 #include "../eval.h"
 #include "../tt.h"
 #include "../tables.h"
+#include "../movesort.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -31,6 +32,10 @@ u8 uci_parse_move(const char *str, Move *m) {
     u16 num_moves, base_idx, i;
 
     if (strlen(str) < 4) return 0;
+    if (str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8' ||
+        str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8') {
+        return 0;
+    }
 
     from = SQ_MAKE(str[1] - '1', str[0] - 'a');
     to = SQ_MAKE(str[3] - '1', str[2] - 'a');
@@ -44,9 +49,9 @@ u8 uci_parse_move(const char *str, Move *m) {
 
     for (i = 0; i < num_moves; i++) {
         Move *mv = &g_state.move_buf[base_idx + i];
-        if (mv->from == from && mv->to == to) {
+        if (MOVE_FROM(*mv) == from && MOVE_TO(*mv) == to) {
             /* Check promotion piece */
-            if (mv->flags & MF_PROMO) {
+            if (MOVE_FLAGS(*mv) & MF_PROMO) {
                 char promo_ch = (strlen(str) >= 5) ? str[4] : 'q';
                 u8 promo_type;
                 switch (promo_ch) {
@@ -55,7 +60,7 @@ u8 uci_parse_move(const char *str, Move *m) {
                     case 'r': promo_type = ROOK; break;
                     default:  promo_type = QUEEN; break;
                 }
-                if (PROMO_TYPE(mv->flags) == promo_type) {
+                if (PROMO_TYPE(MOVE_FLAGS(*mv)) == promo_type) {
                     *m = *mv;
                     return 1;
                 }
@@ -69,13 +74,15 @@ u8 uci_parse_move(const char *str, Move *m) {
 }
 
 void uci_format_move(Move m, char *buf) {
-    buf[0] = (char)('a' + SQ_FILE(m.from));
-    buf[1] = (char)('1' + SQ_RANK(m.from));
-    buf[2] = (char)('a' + SQ_FILE(m.to));
-    buf[3] = (char)('1' + SQ_RANK(m.to));
-    if (m.flags & MF_PROMO) {
+    u8 from = MOVE_FROM(m), to = MOVE_TO(m), flags = MOVE_FLAGS(m);
+
+    buf[0] = (char)('a' + SQ_FILE(from));
+    buf[1] = (char)('1' + SQ_RANK(from));
+    buf[2] = (char)('a' + SQ_FILE(to));
+    buf[3] = (char)('1' + SQ_RANK(to));
+    if (flags & MF_PROMO) {
         static const char promo_chars[] = "nbrq";
-        buf[4] = promo_chars[PROMO_TYPE(m.flags) - KNIGHT];
+        buf[4] = promo_chars[PROMO_TYPE(flags) - KNIGHT];
         buf[5] = '\0';
     } else {
         buf[4] = '\0';
@@ -95,7 +102,8 @@ static void uci_cmd_position(const char *line) {
     } else if (strncmp(p, "fen", 3) == 0) {
         p += 3;
         while (*p == ' ') p++;
-        board_set_fen(p);
+        /* A FEN the board cannot hold is ignored, moves and all */
+        if (!board_set_fen(p)) return;
         /* Skip past FEN (6 space-separated fields) */
         {
             u8 spaces = 0;
@@ -130,7 +138,8 @@ static void uci_cmd_position(const char *line) {
                     bi2 = g_state.move_buf_idx[0];
                     for (vi2 = 0; vi2 < nm2; vi2++) {
                         Move *mv2 = &g_state.move_buf[bi2 + vi2];
-                        if (mv2->from == m.from && mv2->to == m.to) {
+                        if (MOVE_FROM(*mv2) == MOVE_FROM(m) &&
+                            MOVE_TO(*mv2) == MOVE_TO(m)) {
                             if (board_make_move(*mv2)) { applied = 1; break; }
                         }
                     }
@@ -139,7 +148,7 @@ static void uci_cmd_position(const char *line) {
                             char fen[128];
                             board_get_fen(fen);
                             fprintf(dbg_file, "DESYNC_MAKE: from=%02x to=%02x fen=%s\n",
-                                    m.from, m.to, fen);
+                                    MOVE_FROM(m), MOVE_TO(m), fen);
                             fflush(dbg_file);
                         }
                     }
@@ -166,61 +175,141 @@ static void uci_cmd_position(const char *line) {
     dbg_board("POSITION_FINAL");
 }
 
-static void uci_cmd_go(const char *line) {
-    const char *p = line;
-    u8 max_depth = 20;
-    u32 max_time = 0;
-    s32 wtime = -1, btime = -1;
-    s32 winc = 0, binc = 0;
-    u32 movetime = 0;
-    SearchResult result;
+/* Legal move paths of the given length, bulk-counted at the last ply */
+static u32 perft_count(u8 depth, u8 ply) {
+    u32 nodes = 0;
+    u16 num_moves, i, base_idx;
+
+    num_moves = movegen_generate_legal(ply);
+    if (depth <= 1) return depth == 1 ? num_moves : 1;
+
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        board_make_legal_move(g_state.move_buf[base_idx + i]);
+        nodes += perft_count(depth - 1, ply + 1);
+        board_unmake_move(g_state.move_buf[base_idx + i]);
+    }
+    return nodes;
+}
+
+/* With divide, the node count under each root move and then the total
+ * are printed (the format other engines use, so tools can also read the
+ * root moves) */
+u32 uci_perft(u8 depth, u8 divide) {
+    u32 nodes, total = 0;
+    u16 num_moves, i;
+    Move m;
     char move_str[6];
 
-    /* Parse go parameters */
+    if (depth < 1) depth = 1;
+    g_state.move_buf_idx[0] = 0;
+    num_moves = movegen_generate_legal(0);
+    for (i = 0; i < num_moves; i++) {
+        m = g_state.move_buf[i];
+        board_make_legal_move(m);
+        nodes = perft_count((u8)(depth - 1), 1);
+        board_unmake_move(m);
+        if (divide) {
+            uci_format_move(m, move_str);
+            printf("%s: %lu\n", move_str, (unsigned long)nodes);
+        }
+        total += nodes;
+    }
+    if (divide) {
+        printf("\nNodes searched: %lu\n\n", (unsigned long)total);
+        fflush(stdout);
+    }
+    return total;
+}
+
+void uci_parse_go(const char *line, UciGo *go) {
+    const char *p = line;
+
+    go->depth = 20;
+    go->perft = 0;
+    go->movetime = 0;
+    go->wtime = -1;
+    go->btime = -1;
+    go->winc = 0;
+    go->binc = 0;
+    go->root_count = 0;
+
     while (*p) {
         while (*p == ' ') p++;
 
-        if (strncmp(p, "depth", 5) == 0) {
+        if (strncmp(p, "perft", 5) == 0) {
             p += 5;
             while (*p == ' ') p++;
-            max_depth = (u8)atoi(p);
-            if (max_depth > MAX_PLY - 4) max_depth = MAX_PLY - 4;
+            go->perft = (u8)atoi(p);
+            if (go->perft < 1) go->perft = 1;
+            return;
+        } else if (strncmp(p, "searchmoves", 11) == 0) {
+            /* Moves up to the next keyword */
+            p += 11;
+            for (;;) {
+                while (*p == ' ') p++;
+                if (go->root_count >= MAX_MOVES ||
+                    !uci_parse_move(p, &go->root_moves[go->root_count])) {
+                    break;
+                }
+                go->root_count++;
+                while (*p && *p != ' ') p++;
+            }
+            continue;
+        } else if (strncmp(p, "depth", 5) == 0) {
+            p += 5;
+            while (*p == ' ') p++;
+            go->depth = (u8)atoi(p);
+            if (go->depth > MAX_PLY - 4) go->depth = MAX_PLY - 4;
         } else if (strncmp(p, "movetime", 8) == 0) {
             p += 8;
             while (*p == ' ') p++;
-            movetime = (u32)atol(p);
+            go->movetime = (u32)atol(p);
         } else if (strncmp(p, "wtime", 5) == 0) {
             p += 5;
             while (*p == ' ') p++;
-            wtime = atol(p);
+            go->wtime = atol(p);
         } else if (strncmp(p, "btime", 5) == 0) {
             p += 5;
             while (*p == ' ') p++;
-            btime = atol(p);
+            go->btime = atol(p);
         } else if (strncmp(p, "winc", 4) == 0) {
             p += 4;
             while (*p == ' ') p++;
-            winc = atol(p);
+            go->winc = atol(p);
         } else if (strncmp(p, "binc", 4) == 0) {
             p += 4;
             while (*p == ' ') p++;
-            binc = atol(p);
+            go->binc = atol(p);
         } else if (strncmp(p, "infinite", 8) == 0) {
-            max_depth = MAX_PLY - 4;
+            go->depth = MAX_PLY - 4;
             p += 8;
         }
 
         /* Skip to next token */
         while (*p && *p != ' ') p++;
     }
+}
+
+static void uci_cmd_go(const char *line) {
+    static UciGo go;    /* 0.5KB of root moves: not on the stack */
+    u32 max_time = 0;
+    SearchResult result;
+    char move_str[6];
+
+    uci_parse_go(line, &go);
+    if (go.perft) {
+        uci_perft(go.perft, 1);
+        return;
+    }
 
     /* Determine time for this move */
-    if (movetime > 0) {
-        max_time = movetime;
-    } else if (wtime >= 0 || btime >= 0) {
+    if (go.movetime > 0) {
+        max_time = go.movetime;
+    } else if (go.wtime >= 0 || go.btime >= 0) {
         /* Time management: use 1/20th of remaining time + most of increment */
-        s32 our_time = (g_state.side == WHITE) ? wtime : btime;
-        s32 our_inc = (g_state.side == WHITE) ? winc : binc;
+        s32 our_time = (g_state.side == WHITE) ? go.wtime : go.btime;
+        s32 our_inc = (g_state.side == WHITE) ? go.winc : go.binc;
         if (our_time > 0) {
             max_time = (u32)(our_time / 20 + our_inc * 3 / 4);
             if (max_time > (u32)our_time - 50) {
@@ -232,10 +321,11 @@ static void uci_cmd_go(const char *line) {
     }
 
     dbg_open();
-    result = search_position(max_depth, max_time);
+    search_set_root_moves(go.root_moves, go.root_count);
+    result = search_position(go.depth, max_time);
 
     /* Verify bestmove is legal before outputting */
-    if (result.best_move.from == 0 && result.best_move.to == 0) {
+    if (IS_MOVE_NONE(result.best_move)) {
         dbg_board("BESTMOVE_0000");
         printf("bestmove 0000\n");
     } else {
@@ -247,8 +337,8 @@ static void uci_cmd_go(const char *line) {
         bi = g_state.move_buf_idx[0];
         for (vi = 0; vi < nm; vi++) {
             Move *mv = &g_state.move_buf[bi + vi];
-            if (mv->from == result.best_move.from &&
-                mv->to == result.best_move.to) {
+            if (MOVE_FROM(*mv) == MOVE_FROM(result.best_move) &&
+                MOVE_TO(*mv) == MOVE_TO(result.best_move)) {
                 /* Also verify it doesn't leave king in check */
                 if (board_make_move(*mv)) {
                     board_unmake_move(*mv);
@@ -265,8 +355,8 @@ static void uci_cmd_go(const char *line) {
                 char fen[128];
                 board_get_fen(fen);
                 fprintf(dbg_file, "BESTMOVE_OK: %s from=%02x to=%02x flags=%02x fen=%s\n",
-                        move_str, result.best_move.from, result.best_move.to,
-                        result.best_move.flags, fen);
+                        move_str, MOVE_FROM(result.best_move), MOVE_TO(result.best_move),
+                        MOVE_FLAGS(result.best_move), fen);
                 fflush(dbg_file);
             }
             printf("bestmove %s\n", move_str);
@@ -276,7 +366,7 @@ static void uci_cmd_go(const char *line) {
                 char fen[128];
                 board_get_fen(fen);
                 fprintf(dbg_file, "BESTMOVE_FAIL: search_from=%02x search_to=%02x fen=%s\n",
-                        result.best_move.from, result.best_move.to, fen);
+                        MOVE_FROM(result.best_move), MOVE_TO(result.best_move), fen);
                 fflush(dbg_file);
             }
             for (vi = 0; vi < nm; vi++) {
@@ -301,6 +391,42 @@ static void uci_cmd_go(const char *line) {
     fflush(stdout);
 }
 
+/* Check option switching one forward pruning technique */
+static void uci_set_pruning(u8 technique, const char *value) {
+    if (strncmp(value, "true", 4) == 0) {
+        search_set_pruning((u8)(search_get_pruning() | technique));
+    } else {
+        search_set_pruning((u8)(search_get_pruning() & ~technique));
+    }
+}
+
+static void uci_cmd_setoption(const char *line) {
+    const char *name = strstr(line, "name ");
+    const char *value = strstr(line, "value ");
+    int n;
+
+    if (!name || !value) return;
+    name += 5;
+    value += 6;
+
+    if (strncmp(name, "Threads", 7) == 0) {
+        n = atoi(value);
+        search_set_threads((u16)(n < 1 ? 1 : n > SEARCH_MAX_THREADS ? SEARCH_MAX_THREADS : n));
+    }
+    else if (strncmp(name, "RFP ", 4) == 0) {
+        uci_set_pruning(PRUNE_RFP, value);
+    }
+    else if (strncmp(name, "Razoring ", 9) == 0) {
+        uci_set_pruning(PRUNE_RAZORING, value);
+    }
+    else if (strncmp(name, "Futility ", 9) == 0) {
+        uci_set_pruning(PRUNE_FUTILITY, value);
+    }
+    else if (strncmp(name, "LMP ", 4) == 0) {
+        uci_set_pruning(PRUNE_LMP, value);
+    }
+}
+
 void uci_loop(void) {
     char line[4096];
 
@@ -323,6 +449,12 @@ void uci_loop(void) {
         if (strcmp(line, "uci") == 0) {
             printf("id name %s\n", ENGINE_NAME);
             printf("id author %s\n", ENGINE_AUTHOR);
+            printf("option name Threads type spin default 1 min 1 max %d\n",
+                   SEARCH_MAX_THREADS);
+            printf("option name RFP type check default true\n");
+            printf("option name Razoring type check default true\n");
+            printf("option name Futility type check default true\n");
+            printf("option name LMP type check default true\n");
             printf("uciok\n");
             fflush(stdout);
         }
@@ -333,6 +465,10 @@ void uci_loop(void) {
         else if (strcmp(line, "ucinewgame") == 0) {
             board_init();
             tt_clear();
+            movesort_clear_history();
+        }
+        else if (strncmp(line, "setoption", 9) == 0) {
+            uci_cmd_setoption(line + 9);
         }
         else if (strncmp(line, "position", 8) == 0) {
             uci_cmd_position(line + 8);
@@ -17,4 +17,24 @@ u8 uci_parse_move(const char *str, Move *m);
 /* Format a move as UCI string (writes to buf, must be >= 6 bytes) */
 void uci_format_move(Move m, char *buf);
 
+/* Arguments of a "go" command */
+typedef struct {
+    u8   depth;          /* 20 unless given */
+    u8   perft;          /* go perft N: N (at least 1), else 0 */
+    u32  movetime;       /* 0 if not given */
+    s32  wtime, btime;   /* -1 if not given */
+    s32  winc, binc;
+    u16  root_count;     /* go searchmoves: the moves (0: all) */
+    Move root_moves[MAX_MOVES];
+} UciGo;
+
+/* Parse the arguments of "go" (the text after it) in the current
+ * position. The searchmoves list ends at the first token that is not a
+ * legal move here, e.g. the next keyword. */
+void uci_parse_go(const char *line, UciGo *go);
+
+/* Legal move paths of depth plies from the current position ("go perft");
+ * divide prints the count under each root move and the total */
+u32 uci_perft(u8 depth, u8 divide);
+
 #endif /* UCI_H */
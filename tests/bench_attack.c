@@ -0,0 +1,161 @@
+/*
+ * Attack detection microbenchmark
+ * Walks the perft trees of the test_movegen.c positions and, at every
+ * node, asks whether each square is attacked by each side. The engine's
+ * board_is_square_attacked is timed against a reference ray scan (the
+ * original algorithm: probe 8 knight and 8 king squares, walk all 8 rays)
+ * and both must agree on every query.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "../src/types.h"
+#include "../src/board.h"
+#include "../src/movegen.h"
+#include "../src/tables.h"
+
+#define MODE_WALK      0   /* tree walk only (baseline overhead) */
+#define MODE_REFERENCE 1
+#define MODE_ENGINE    2
+#define MODE_VERIFY    3
+
+static u32 queries;
+static u32 mismatches;
+static u32 sink;
+
+/* Reference: scan outward from sq with no lookup tables */
+static u8 attacked_by_scan(u8 sq, u8 by_side) {
+    static const s8 king_dirs[8] = { -17, -16, -15, -1, 1, 15, 16, 17 };
+    u8 i, target, piece, pt;
+    u8 opp_color = by_side ? COLOR_MASK : 0;
+    s8 dir;
+
+    for (i = 0; i < 8; i++) {
+        target = (u8)((s8)sq + knight_offsets[i]);
+        if (SQ_VALID(target) && g_state.board[target] == (opp_color | KNIGHT)) return 1;
+        target = (u8)((s8)sq + king_dirs[i]);
+        if (SQ_VALID(target) && g_state.board[target] == (opp_color | KING)) return 1;
+    }
+
+    if (by_side == WHITE) {
+        target = (u8)(sq - 15);
+        if (SQ_VALID(target) && g_state.board[target] == W_PAWN) return 1;
+        target = (u8)(sq - 17);
+        if (SQ_VALID(target) && g_state.board[target] == W_PAWN) return 1;
+    } else {
+        target = (u8)(sq + 15);
+        if (SQ_VALID(target) && g_state.board[target] == B_PAWN) return 1;
+        target = (u8)(sq + 17);
+        if (SQ_VALID(target) && g_state.board[target] == B_PAWN) return 1;
+    }
+
+    for (i = 0; i < 8; i++) {
+        dir = king_dirs[i];
+        target = (u8)((s8)sq + dir);
+        while (SQ_VALID(target)) {
+            piece = g_state.board[target];
+            if (piece != EMPTY) {
+                if ((piece & COLOR_MASK) == opp_color) {
+                    pt = PIECE_TYPE(piece);
+                    if (pt == QUEEN) return 1;
+                    if (pt == ((dir == 1 || dir == -1 || dir == 16 || dir == -16) ?
+                               ROOK : BISHOP)) return 1;
+                }
+                break;
+            }
+            target = (u8)((s8)target + dir);
+        }
+    }
+    return 0;
+}
+
+static void query_all(u8 mode) {
+    u8 sq, side, a, b;
+
+    for (sq = 0; sq < 128; sq++) {
+        if (!SQ_VALID(sq)) continue;
+        for (side = 0; side < 2; side++) {
+            queries++;
+            switch (mode) {
+                case MODE_REFERENCE:
+                    sink += attacked_by_scan(sq, side);
+                    break;
+                case MODE_ENGINE:
+                    sink += board_is_square_attacked(sq, side);
+                    break;
+                case MODE_VERIFY:
+                    a = attacked_by_scan(sq, side);
+                    b = board_is_square_attacked(sq, side);
+                    if (a != b) mismatches++;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+static void walk(u8 depth, u8 ply, u8 mode) {
+    u16 num_moves, i, base_idx;
+
+    query_all(mode);
+    if (depth == 0) return;
+
+    num_moves = movegen_generate(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        if (board_make_move(g_state.move_buf[base_idx + i])) {
+            walk(depth - 1, ply + 1, mode);
+            board_unmake_move(g_state.move_buf[base_idx + i]);
+        }
+    }
+}
+
+static double time_walk(const char *fen, u8 depth, u8 mode) {
+    clock_t start;
+    board_set_fen(fen);
+    start = clock();
+    walk(depth, 0, mode);
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+void bench_attack(void) {
+    static const char *fens[5] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+    };
+    static const char *names[5] = { "Start", "Kiwipete", "Pos3", "Pos4", "Pos5" };
+    static const u8 depths[5] = { 3, 3, 4, 3, 3 };
+    double t_walk, t_ref, t_eng, total_ref = 0, total_eng = 0;
+    u32 n;
+    u8 p;
+
+    printf("  %-9s %10s %10s %10s %8s\n", "position", "queries", "scan ms", "engine ms", "speedup");
+    for (p = 0; p < 5; p++) {
+        mismatches = 0;
+        queries = 0;
+        time_walk(fens[p], depths[p], MODE_VERIFY);
+        if (mismatches) {
+            printf("  %s: %lu MISMATCHES against reference scan\n",
+                   names[p], (unsigned long)mismatches);
+        }
+
+        queries = 0;
+        t_walk = time_walk(fens[p], depths[p], MODE_WALK);
+        n = queries;
+        t_ref = time_walk(fens[p], depths[p], MODE_REFERENCE) - t_walk;
+        t_eng = time_walk(fens[p], depths[p], MODE_ENGINE) - t_walk;
+        total_ref += t_ref;
+        total_eng += t_eng;
+
+        printf("  %-9s %10lu %10.1f %10.1f %7.2fx\n", names[p], (unsigned long)n,
+               t_ref * 1000.0, t_eng * 1000.0, t_eng > 0 ? t_ref / t_eng : 0.0);
+    }
+    printf("  %-9s %10s %10.1f %10.1f %7.2fx\n", "total", "",
+           total_ref * 1000.0, total_eng * 1000.0,
+           total_eng > 0 ? total_ref / total_eng : 0.0);
+    (void)sink;
+}
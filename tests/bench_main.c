@@ -0,0 +1,57 @@
+/*
+ * C64 Chess Engine - Benchmark Harness
+ * Runs the PC microbenchmarks. Build with "make bench" (PC backend) or
+ * "make bench-0x88" (the C64's 0x88 backend on PC); "make bench-copy"
+ * switches make/unmake to copy-make.
+ */
+
+#include <stdio.h>
+#include "../src/types.h"
+#include "../src/tables.h"
+
+/* External benchmark functions */
+extern void bench_attack(void);
+extern void bench_perft(void);
+extern void bench_search(void);
+extern void bench_pruning(void);
+extern void bench_smp(void);
+
+int main(void) {
+    tables_init();
+
+    printf("=== C64 Chess Engine Benchmarks ===\n");
+#ifdef USE_BITBOARDS
+    printf("Backend: bitboards");
+#else
+    printf("Backend: 0x88");
+#endif
+#ifdef ATTACK_MAPS
+    printf(", incremental attack maps");
+#endif
+#ifdef COPY_MAKE
+    printf(", copy-make (%u byte position)", (unsigned)POSITION_BYTES);
+#endif
+    printf("\n\n");
+
+    printf("--- Attack Detection ---\n");
+    bench_attack();
+    printf("\n");
+
+    printf("--- Perft Throughput ---\n");
+    bench_perft();
+    printf("\n");
+
+    printf("--- Search to Fixed Depth ---\n");
+    bench_search();
+    printf("\n");
+
+    printf("--- Forward Pruning ---\n");
+    bench_pruning();
+    printf("\n");
+
+    printf("--- Lazy SMP Scaling ---\n");
+    bench_smp();
+    printf("\n");
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Perft throughput benchmark
+ * Times perft over the test_movegen.c positions. Every node pays for
+ * move generation, make/unmake and the legality test, so comparing
+ * builds (e.g. make bench-0x88 vs make bench-maps) weighs the cost of
+ * incremental board upkeep against on-demand attack scans. The second
+ * table runs the legal generator with bulk counting at the last ply; the
+ * third counts the last ply with movegen_count_legal instead.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "../src/types.h"
+#include "../src/board.h"
+#include "../src/movegen.h"
+
+static u32 perft(u8 depth, u8 ply) {
+    u32 nodes = 0;
+    u16 num_moves, i, base_idx;
+
+    if (depth == 0) return 1;
+
+    num_moves = movegen_generate(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        if (board_make_move(g_state.move_buf[base_idx + i])) {
+            nodes += perft(depth - 1, ply + 1);
+            board_unmake_move(g_state.move_buf[base_idx + i]);
+        }
+    }
+    return nodes;
+}
+
+static u32 perft_legal(u8 depth, u8 ply) {
+    u32 nodes = 0;
+    u16 num_moves, i, base_idx;
+
+    num_moves = movegen_generate_legal(ply);
+    if (depth <= 1) return depth == 1 ? num_moves : 1;
+
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        board_make_legal_move(g_state.move_buf[base_idx + i]);
+        nodes += perft_legal(depth - 1, ply + 1);
+        board_unmake_move(g_state.move_buf[base_idx + i]);
+    }
+    return nodes;
+}
+
+static u32 perft_count(u8 depth, u8 ply) {
+    u32 nodes = 0;
+    u16 num_moves, i, base_idx;
+
+    if (depth <= 1) return depth == 1 ? movegen_count_legal() : 1;
+
+    num_moves = movegen_generate_legal(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        board_make_legal_move(g_state.move_buf[base_idx + i]);
+        nodes += perft_count(depth - 1, ply + 1);
+        board_unmake_move(g_state.move_buf[base_idx + i]);
+    }
+    return nodes;
+}
+
+static const char *fens[5] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+};
+static const char *names[5] = { "Start", "Kiwipete", "Pos3", "Pos4", "Pos5" };
+static const u8 depths[5] = { 5, 4, 5, 4, 4 };
+
+static void bench_table(u32 (*count)(u8, u8)) {
+    u32 nodes, total_nodes = 0;
+    double t, total_t = 0;
+    clock_t start;
+    u8 p;
+
+    printf("  %-9s %5s %10s %9s %9s\n", "position", "depth", "nodes", "ms", "knps");
+    for (p = 0; p < 5; p++) {
+        board_set_fen(fens[p]);
+        start = clock();
+        nodes = count(depths[p], 0);
+        t = (double)(clock() - start) / CLOCKS_PER_SEC;
+        total_nodes += nodes;
+        total_t += t;
+        printf("  %-9s %5d %10lu %9.1f %9.0f\n", names[p], depths[p],
+               (unsigned long)nodes, t * 1000.0, t > 0 ? nodes / t / 1000.0 : 0.0);
+    }
+    printf("  %-9s %5s %10lu %9.1f %9.0f\n", "total", "", (unsigned long)total_nodes,
+           total_t * 1000.0, total_t > 0 ? total_nodes / total_t / 1000.0 : 0.0);
+}
+
+void bench_perft(void) {
+    printf("  pseudo-legal, make-and-test:\n");
+    bench_table(perft);
+    printf("  legal generator, bulk counting:\n");
+    bench_table(perft_legal);
+    printf("  legal generator, movegen_count_legal at the last ply:\n");
+    bench_table(perft_count);
+}
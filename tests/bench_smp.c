@@ -0,0 +1,63 @@
+/*
+ * Lazy SMP scaling benchmark
+ * Searches a fixed position set to a fixed depth with 1, 2, 4, 8 and 16
+ * threads, clearing the TT before each position. "speedup" is the
+ * time-to-depth of 1 thread over that of n threads; "nps x" is total
+ * nodes/sec over the 1-thread figure. Helpers also search nodes the main
+ * thread never needs, so nps scales better than time-to-depth. Both are
+ * bounded by the machine's core count.
+ */
+
+#include <stdio.h>
+#include "../src/types.h"
+#include "../src/board.h"
+#include "../src/search.h"
+#include "../src/tt.h"
+
+#define SMP_DEPTH 8
+
+static const char *fens[6] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N2N2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    "2rq1rk1/pp1bbppp/2n1pn2/3p4/3P4/P1NBPN2/1P3PPP/R2Q1RK1 w - - 0 11",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+};
+
+static const u8 thread_counts[5] = { 1, 2, 4, 8, 16 };
+
+void bench_smp(void) {
+    SearchResult res;
+    u32 start, ms, total_ms, nodes, base_ms = 0;
+    double nps, base_nps = 0;
+    u8 t, p, threads;
+
+    search_set_info_output(0);
+    printf("  %d positions to depth %d\n", 6, SMP_DEPTH);
+    printf("  %7s %9s %8s %10s %6s\n", "threads", "ms", "speedup", "knps", "nps x");
+    for (t = 0; t < 5; t++) {
+        threads = search_set_threads(thread_counts[t]);
+        total_ms = 0;
+        nodes = 0;
+        for (p = 0; p < 6; p++) {
+            board_set_fen(fens[p]);
+            tt_clear();
+            start = get_time_ms();
+            res = search_position(SMP_DEPTH, 0);
+            ms = get_time_ms() - start;
+            total_ms += ms;
+            nodes += res.nodes;
+        }
+        nps = total_ms > 0 ? nodes * 1000.0 / total_ms : 0.0;
+        if (t == 0) {
+            base_ms = total_ms;
+            base_nps = nps;
+        }
+        printf("  %7d %9lu %8.2f %10.0f %6.2f\n", threads, (unsigned long)total_ms,
+               total_ms > 0 ? (double)base_ms / total_ms : 0.0, nps / 1000.0,
+               base_nps > 0 ? nps / base_nps : 0.0);
+    }
+    search_set_threads(1);
+    search_set_info_output(1);
+}
@@ -4,6 +4,7 @@
  * - Make/unmake move
  * - Zobrist hash consistency
  * - Attack detection
+ * - Piece list consistency
  */
 
 #include <stdio.h>
@@ -12,6 +13,7 @@
 #include "../src/board.h"
 #include "../src/tables.h"
 #include "../src/tt.h"
+#include "../src/movegen.h"
 
 extern int tests_run, tests_passed, tests_failed;
 
@@ -21,6 +23,95 @@ extern int tests_run, tests_passed, tests_failed;
     else { tests_failed++; printf("  FAIL: %s\n", msg); } \
 } while(0)
 
+/* Compare the live part of two piece list snapshots (slots past the
+ * count are stale and may differ) */
+static u8 piece_lists_equal(u8 a[2][7][MAX_PIECE_SLOTS], u8 b[2][7][MAX_PIECE_SLOTS]) {
+    u8 color, pt, n;
+    for (color = 0; color < 2; color++) {
+        for (pt = PAWN; pt <= KING; pt++) {
+            for (n = 0; n < g_state.piece_count[color][pt]; n++) {
+                if (a[color][pt][n] != b[color][pt][n]) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Verify piece lists against the board: every listed square holds the
+ * listed piece with a matching back-pointer, and no piece is missing. */
+static u8 piece_lists_consistent(void) {
+    u8 color, pt, n, sq, listed = 0, on_board = 0;
+
+    for (color = 0; color < 2; color++) {
+        for (pt = PAWN; pt <= KING; pt++) {
+            for (n = 0; n < g_state.piece_count[color][pt]; n++) {
+                sq = g_state.piece_list[color][pt][n];
+                if (g_state.board[sq] != MAKE_PIECE(color, pt)) return 0;
+                if (g_state.piece_index[sq] != n) return 0;
+                listed++;
+            }
+        }
+    }
+    for (sq = 0; sq < 128; sq++) {
+        if (SQ_VALID(sq) && g_state.board[sq] != EMPTY) on_board++;
+    }
+    return listed == on_board;
+}
+
+static u8 keys_ok;
+
+/* Compare the incremental hash, pawn and material keys with from-scratch
+ * versions at every node of a small tree */
+static void check_keys(u8 depth, u8 ply) {
+    u16 num_moves, i, base_idx;
+
+    if (g_state.hash != board_compute_hash() ||
+        g_state.pawn_hash != board_compute_pawn_hash() ||
+        g_state.material_hash != board_compute_material_hash()) {
+        keys_ok = 0;
+    }
+    if (depth == 0) return;
+
+    num_moves = movegen_generate(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        if (board_make_move(g_state.move_buf[base_idx + i])) {
+            check_keys(depth - 1, ply + 1);
+            board_unmake_move(g_state.move_buf[base_idx + i]);
+        }
+    }
+}
+
+#ifdef ATTACK_MAPS
+static u8 maps_ok;
+
+/* Compare the incremental attack maps with a from-scratch rebuild at
+ * every node of a small tree */
+static void check_attack_maps(u8 depth, u8 ply) {
+    static u16 saved_attackers[2][128];
+    static u8 saved_count[2][128];
+    u16 num_moves, i, base_idx;
+
+    memcpy(saved_attackers, g_state.attackers, sizeof(saved_attackers));
+    memcpy(saved_count, g_state.attack_count, sizeof(saved_count));
+    board_init_attack_maps();
+    if (memcmp(saved_attackers, g_state.attackers, sizeof(saved_attackers)) != 0 ||
+        memcmp(saved_count, g_state.attack_count, sizeof(saved_count)) != 0) {
+        maps_ok = 0;
+    }
+    if (depth == 0) return;
+
+    num_moves = movegen_generate(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        if (board_make_move(g_state.move_buf[base_idx + i])) {
+            check_attack_maps(depth - 1, ply + 1);
+            board_unmake_move(g_state.move_buf[base_idx + i]);
+        }
+    }
+}
+#endif
+
 void test_board(void) {
     char fen_buf[100];
 
@@ -56,11 +147,23 @@ void test_board(void) {
     TEST_ASSERT(g_state.board[SQ_MAKE(4, 4)] == W_KNIGHT, "Kiwipete: knight on e5");
     TEST_ASSERT(g_state.castle_rights == CASTLE_ALL, "Kiwipete: all castling rights");
 
+    /* Test 6b: a FEN with more pieces of a kind than a piece list holds
+     * (11 white queens) is rejected and the position is kept */
+    {
+        HashKey hash = g_state.hash;
+        u8 ok = board_set_fen("QQQQQQQQ/QQQ5/8/8/8/8/8/K6k w - - 0 1");
+        TEST_ASSERT(!ok && g_state.hash == hash &&
+                    g_state.board[SQ_MAKE(4, 4)] == W_KNIGHT &&
+                    board_set_fen("QQQQQQQQ/QQ6/8/8/8/8/8/K6k w - - 0 1") &&
+                    g_state.piece_count[WHITE][QUEEN] == 10,
+                    "FEN overflowing a piece list is rejected");
+    }
+
     /* Test 7: Zobrist hash consistency */
     board_init();
     {
-        u16 hash1 = g_state.hash;
-        u16 hash2 = board_compute_hash();
+        HashKey hash1 = g_state.hash;
+        HashKey hash2 = board_compute_hash();
         TEST_ASSERT(hash1 == hash2, "Zobrist hash matches computed hash");
     }
 
@@ -68,11 +171,7 @@ void test_board(void) {
     board_init();
     {
         HashKey hash_before = g_state.hash;
-        Move m;
-        m.from = SQ_MAKE(1, 4); /* e2 */
-        m.to = SQ_MAKE(3, 4);   /* e4 */
-        m.flags = MF_PAWNSTART;
-        m.score = 0;
+        Move m = MOVE_PACK(SQ_MAKE(1, 4), SQ_MAKE(3, 4), MF_PAWNSTART); /* e2e4 */
 
         if (board_make_move(m)) {
             board_unmake_move(m);
@@ -93,10 +192,7 @@ void test_board(void) {
 
         memcpy(board_copy, g_state.board, 128);
 
-        m.from = SQ_MAKE(0, 6); /* g1 */
-        m.to = SQ_MAKE(2, 5);   /* f3 */
-        m.flags = MF_NONE;
-        m.score = 0;
+        m = MOVE_PACK(SQ_MAKE(0, 6), SQ_MAKE(2, 5), MF_NONE); /* g1f3 */
 
         if (board_make_move(m)) {
             board_unmake_move(m);
@@ -118,14 +214,32 @@ void test_board(void) {
     TEST_ASSERT(board_is_square_attacked(SQ_MAKE(4, 4), WHITE) == 0,
         "e5 not attacked by white in start pos");
 
+    /* Test 10b: 0x88 attack/delta table geometry */
+    TEST_ASSERT((attack_table[ATTACK_INDEX(SQ_A1, SQ_H8)] & ATK_BISHOP) &&
+                delta_table[ATTACK_INDEX(SQ_A1, SQ_H8)] == -17,
+        "attack_table: a1 bishop reaches h8, step back is -17");
+    TEST_ASSERT(!(attack_table[ATTACK_INDEX(SQ_A1, SQ_H8)] & ATK_ROOK) &&
+                !(attack_table[ATTACK_INDEX(SQ_B1, SQ_H8)] & ATK_QUEEN),
+        "attack_table: rejects a1-h8 rook and b1-h8 queen");
+    TEST_ASSERT((attack_table[ATTACK_INDEX(SQ_G1, SQ_MAKE(2, 5))] & ATK_KNIGHT) &&
+                (attack_table[ATTACK_INDEX(SQ_MAKE(1, 4), SQ_MAKE(2, 5))] & ATK_WPAWN) &&
+                !(attack_table[ATTACK_INDEX(SQ_MAKE(1, 4), SQ_MAKE(2, 5))] & ATK_BPAWN),
+        "attack_table: knight and pawn geometry");
+
+    /* Test 10c: slider attacks are blocked by interposed pieces */
+    board_set_fen("4k3/8/8/8/1b6/8/3P4/4K2R w K - 0 1");
+    TEST_ASSERT(board_is_square_attacked(SQ_MAKE(2, 2), BLACK) == 1,
+        "c3 attacked by black bishop on b4");
+    TEST_ASSERT(board_is_square_attacked(SQ_E1, BLACK) == 0,
+        "e1 shielded from b4 bishop by d2 pawn");
+    TEST_ASSERT(board_is_square_attacked(SQ_F1, WHITE) == 1 &&
+                board_is_square_attacked(SQ_MAKE(7, 7), WHITE) == 1,
+        "h1 rook attacks along rank and file");
+
     /* Test 11: EP square set after double pawn push */
     board_init();
     {
-        Move m;
-        m.from = SQ_MAKE(1, 4); /* e2 */
-        m.to = SQ_MAKE(3, 4);   /* e4 */
-        m.flags = MF_PAWNSTART;
-        m.score = 0;
+        Move m = MOVE_PACK(SQ_MAKE(1, 4), SQ_MAKE(3, 4), MF_PAWNSTART); /* e2e4 */
 
         board_make_move(m);
         TEST_ASSERT(g_state.ep_square == SQ_MAKE(2, 4),
@@ -142,4 +256,130 @@ void test_board(void) {
         TEST_ASSERT(g_state.material[BLACK] == expected,
             "Black material correct in start pos");
     }
+
+    /* Test 13: Piece lists track FEN setup and survive make/unmake of
+     * every move (captures, ep, castling, promotions) in the same order */
+    board_set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    TEST_ASSERT(piece_lists_consistent(), "Kiwipete: piece lists match board");
+    TEST_ASSERT(g_state.piece_count[WHITE][PAWN] == 8 &&
+                g_state.piece_count[BLACK][KNIGHT] == 2,
+                "Kiwipete: piece counts correct");
+    {
+        static const char *fens[3] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+        };
+        u8 f, ok = 1;
+        u16 num_moves, i, base_idx;
+        u8 lists_before[2][7][MAX_PIECE_SLOTS];
+
+        for (f = 0; f < 3; f++) {
+            board_set_fen(fens[f]);
+            memcpy(lists_before, g_state.piece_list, sizeof(lists_before));
+            num_moves = movegen_generate(0);
+            base_idx = g_state.move_buf_idx[0];
+            for (i = 0; i < num_moves; i++) {
+                Move m = g_state.move_buf[base_idx + i];
+                if (board_make_move(m)) {
+                    if (!piece_lists_consistent()) ok = 0;
+                    board_unmake_move(m);
+                }
+                if (!piece_lists_consistent() ||
+                    !piece_lists_equal(lists_before, g_state.piece_list)) {
+                    ok = 0;
+                }
+            }
+        }
+        TEST_ASSERT(ok, "Piece lists restored exactly after make/unmake");
+    }
+
+    /* Test 13b: Pawn and material keys track make/unmake, and the
+     * material key depends only on piece counts */
+    {
+        static const char *fens[3] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+        };
+        HashKey mat1, pawn1;
+        u8 f;
+        keys_ok = 1;
+        for (f = 0; f < 3; f++) {
+            board_set_fen(fens[f]);
+            check_keys(3, 0);
+        }
+        TEST_ASSERT(keys_ok, "Hash, pawn and material keys match recompute in perft(3) trees");
+
+        board_set_fen("4k3/1p6/8/8/8/8/6P1/R3K3 w - - 0 1");
+        mat1 = g_state.material_hash;
+        pawn1 = g_state.pawn_hash;
+        board_set_fen("4k3/8/2p5/8/8/8/3P4/4K2R w - - 0 1");
+        TEST_ASSERT(g_state.material_hash == mat1 && g_state.pawn_hash != pawn1,
+                    "Material key ignores placement, pawn key does not");
+    }
+
+    /* Test 13c: Repetition detection and the cuckoo cycle test, on
+     * Nf3 Nf6 Ng1 Ng8 from the start position */
+    board_init();
+    {
+        static const u8 shuffle[4][2] = {
+            { 0x06, 0x25 }, { 0x76, 0x55 }, { 0x25, 0x06 }, { 0x55, 0x76 }
+        };
+        u8 k;
+        for (k = 0; k < 3; k++) {
+            board_make_move(MOVE_PACK(shuffle[k][0], shuffle[k][1], MF_NONE));
+        }
+#ifndef TARGET_C64
+        TEST_ASSERT(board_has_game_cycle(4) && !board_has_game_cycle(3),
+                    "Upcoming repetition found only inside the search tree");
+#endif
+        board_make_move(MOVE_PACK(shuffle[3][0], shuffle[3][1], MF_NONE));
+        TEST_ASSERT(!board_is_repetition(), "Twofold is not a threefold");
+        TEST_ASSERT(board_is_repetition_draw(5) && !board_is_repetition_draw(4),
+                    "Search draws on a repeat after the root only");
+    }
+
+    /* The same with null moves for Black: Nf3, pass, Ng1, pass is back
+     * at the start 4 plies on, but a line with a pass is no repetition */
+    board_init();
+    {
+        board_make_move(MOVE_PACK(0x06, 0x25, MF_NONE));
+        board_make_null();
+        board_make_move(MOVE_PACK(0x25, 0x06, MF_NONE));
+        board_make_null();
+        TEST_ASSERT(!board_is_repetition_draw(5),
+                    "No repetition across null moves in the path");
+    }
+
+#ifndef TARGET_C64
+    /* Test 13d: every reversible non-pawn move is in the cuckoo table */
+    {
+        u16 i, filled = 0;
+        for (i = 0; i < CUCKOO_SIZE; i++) {
+            if (cuckoo_keys[i] != 0) filled++;
+        }
+        TEST_ASSERT(filled == 3668, "Cuckoo table holds 3668 moves");
+    }
+#endif
+
+#ifdef ATTACK_MAPS
+    /* Test 14: Incremental attack maps match a rebuild after every
+     * make/unmake (captures, ep, castling, promotions, discoveries) */
+    {
+        static const char *fens[4] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+        };
+        u8 f;
+        maps_ok = 1;
+        for (f = 0; f < 4; f++) {
+            board_set_fen(fens[f]);
+            check_attack_maps(3, 0);
+        }
+        TEST_ASSERT(maps_ok, "Attack maps match rebuild throughout perft(3) trees");
+    }
+#endif
 }
@@ -9,6 +9,8 @@
 #include "../src/board.h"
 #include "../src/movegen.h"
 #include "../src/tables.h"
+#include "../src/movesort.h"
+#include "../src/see.h"
 
 extern int tests_run, tests_passed, tests_failed;
 
@@ -38,6 +40,186 @@ static u32 perft(u8 depth, u8 ply) {
     return nodes;
 }
 
+/* Perft on the legal generator: no legality test on make, and the last
+ * ply is counted without making its moves (bulk counting) */
+static u32 perft_legal(u8 depth, u8 ply) {
+    u32 nodes = 0;
+    u16 num_moves, i, base_idx;
+
+    num_moves = movegen_generate_legal(ply);
+    if (depth <= 1) return depth == 1 ? num_moves : 1;
+
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        board_make_legal_move(g_state.move_buf[base_idx + i]);
+        nodes += perft_legal(depth - 1, ply + 1);
+        board_unmake_move(g_state.move_buf[base_idx + i]);
+    }
+
+    return nodes;
+}
+
+static u8 evasions_ok;
+static u32 evasion_nodes;
+
+/* At every in-check node of a tree, the evasion generator must produce
+ * exactly the legal generator's moves */
+static void check_evasions(u8 depth, u8 ply) {
+    u16 num_moves, num_evasions, i, j, base_idx, ev_idx;
+
+    num_moves = movegen_generate_legal(ply);
+    base_idx = g_state.move_buf_idx[ply];
+
+    if (board_in_check()) {
+        evasion_nodes++;
+        /* Generate the evasions after the legal list, at ply + 1's slot */
+        num_evasions = movegen_generate_evasions(ply + 1);
+        ev_idx = g_state.move_buf_idx[ply + 1];
+        if (num_evasions != num_moves) evasions_ok = 0;
+        for (i = 0; i < num_evasions; i++) {
+            Move e = g_state.move_buf[ev_idx + i];
+            for (j = 0; j < num_moves; j++) {
+                Move m = g_state.move_buf[base_idx + j];
+                if (m == e) break;
+            }
+            if (j == num_moves) evasions_ok = 0;
+        }
+        g_state.move_buf_idx[ply + 1] = base_idx + num_moves;
+    }
+    if (depth == 0) return;
+
+    for (i = 0; i < num_moves; i++) {
+        board_make_legal_move(g_state.move_buf[base_idx + i]);
+        check_evasions(depth - 1, ply + 1);
+        board_unmake_move(g_state.move_buf[base_idx + i]);
+    }
+}
+
+static u8 gives_check_ok;
+
+/* board_gives_check must agree with making the move and testing */
+static void check_gives_check(u8 depth, u8 ply) {
+    u16 num_moves, i, base_idx;
+    u8 predicted, actual;
+
+    num_moves = movegen_generate_legal(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    for (i = 0; i < num_moves; i++) {
+        Move m = g_state.move_buf[base_idx + i];
+        predicted = board_gives_check(m);
+        board_make_legal_move(m);
+        actual = board_in_check();
+        if (predicted != actual) gives_check_ok = 0;
+        if (depth > 1) check_gives_check(depth - 1, ply + 1);
+        board_unmake_move(m);
+    }
+}
+
+/* movegen_count_legal / movegen_has_legal_move agree with the legal
+ * generator at every node and never write to move_buf */
+static u8 count_legal_ok;
+
+static void check_count_legal(u8 depth, u8 ply) {
+    u16 num_moves, i, base_idx;
+    u16 sentinel;
+
+    num_moves = movegen_generate_legal(ply);
+    base_idx = g_state.move_buf_idx[ply];
+    sentinel = g_state.move_buf[g_state.move_buf_idx[ply + 1]];
+    if (movegen_count_legal() != num_moves ||
+        movegen_has_legal_move() != (num_moves != 0) ||
+        g_state.move_buf[g_state.move_buf_idx[ply + 1]] != sentinel) {
+        count_legal_ok = 0;
+    }
+    if (depth <= 1) return;
+    for (i = 0; i < num_moves; i++) {
+        board_make_legal_move(g_state.move_buf[base_idx + i]);
+        check_count_legal(depth - 1, ply + 1);
+        board_unmake_move(g_state.move_buf[base_idx + i]);
+    }
+}
+
+/* board_is_pseudo_legal and movegen_is_legal must accept exactly the
+ * generated (pseudo-legal / legal) moves among all 65536 move values */
+static u8 pseudo_legal_ok;
+
+static u8 in_list(u16 base_idx, u16 num_moves, Move m) {
+    u16 i;
+    for (i = 0; i < num_moves; i++) {
+        if (g_state.move_buf[base_idx + i] == m) return 1;
+    }
+    return 0;
+}
+
+static void check_pseudo_legal(u8 depth, u8 ply) {
+    u16 num_pseudo, num_legal, pseudo_idx, legal_idx, i;
+    u16 n_pseudo = 0, n_legal = 0;
+    u32 v;
+    Move m;
+
+    num_pseudo = movegen_generate(ply);
+    pseudo_idx = g_state.move_buf_idx[ply];
+    num_legal = movegen_generate_legal(ply + 1);
+    legal_idx = g_state.move_buf_idx[ply + 1];
+
+    /* Generated moves are distinct, so equal counts plus membership of
+     * every accepted value means the sets match */
+    for (v = 0; v <= 0xFFFF; v++) {
+        m = (Move)v;
+        if (board_is_pseudo_legal(m)) {
+            n_pseudo++;
+            if (!in_list(pseudo_idx, num_pseudo, m)) pseudo_legal_ok = 0;
+        }
+        if (movegen_is_legal(m)) {
+            n_legal++;
+            if (!in_list(legal_idx, num_legal, m)) pseudo_legal_ok = 0;
+        }
+    }
+    if (n_pseudo != num_pseudo || n_legal != num_legal) pseudo_legal_ok = 0;
+
+    if (depth <= 1) return;
+    for (i = 0; i < num_legal; i++) {
+        m = g_state.move_buf[legal_idx + i];
+        board_make_legal_move(m);
+        check_pseudo_legal(depth - 1, ply + 2);
+        board_unmake_move(m);
+    }
+}
+
+/* The staged picker must hand out every legal move exactly once, TT move
+ * first, whatever TT move (valid or bogus) it is given */
+static u8 picker_matches_legal(const Move *tt_move) {
+    MovePicker mp;
+    Move m, picked[MAX_MOVES];
+    u16 num_legal, num_picked = 0, i, j, base_idx;
+
+    num_legal = movegen_generate_legal(1);
+    base_idx = g_state.move_buf_idx[1];
+
+    /* Pick at ply 2, after the reference list */
+    g_state.move_buf_idx[2] = base_idx + num_legal;
+    movepicker_init(&mp, 2, tt_move, board_in_check());
+    while (movepicker_next(&mp, &m)) {
+        if (num_picked == MAX_MOVES) return 0;
+        picked[num_picked++] = m;
+    }
+    if (num_picked != num_legal) return 0;
+    if (tt_move && movegen_is_legal(*tt_move) &&
+        picked[0] != *tt_move) {
+        return 0;
+    }
+
+    for (i = 0; i < num_legal; i++) {
+        Move l = g_state.move_buf[base_idx + i];
+        u8 found = 0;
+        for (j = 0; j < num_picked; j++) {
+            if (picked[j] == l) found++;
+        }
+        if (found != 1) return 0;
+    }
+    return 1;
+}
+
 void test_movegen(void) {
     u32 nodes;
     char msg[80];
@@ -129,4 +311,247 @@ void test_movegen(void) {
     nodes = perft(3, 0);
     sprintf(msg, "Pos5 perft(3) = %lu (expected 62379)", (unsigned long)nodes);
     TEST_ASSERT(nodes == 62379, msg);
+
+    /* Legal generator with bulk counting, one ply deeper than above */
+    printf("  Legal generator perft tests...\n");
+    {
+        static const char *fens[5] = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+        };
+        static const char *names[5] = { "Start", "Kiwipete", "Pos3", "Pos4", "Pos5" };
+        static const u8 depths[5] = { 5, 4, 5, 4, 4 };
+        static const u32 expected[5] = { 4865609UL, 4085603UL, 674624UL, 422333UL, 2103487UL };
+        u8 p;
+
+        for (p = 0; p < 5; p++) {
+            board_set_fen(fens[p]);
+            nodes = perft_legal(depths[p], 0);
+            sprintf(msg, "%s legal perft(%d) = %lu (expected %lu)", names[p], depths[p],
+                    (unsigned long)nodes, (unsigned long)expected[p]);
+            TEST_ASSERT(nodes == expected[p], msg);
+        }
+    }
+
+    /* Pins, x-rays through the king and en passant discoveries */
+    {
+        static const char *fens[6] = {
+            "8/8/8/KPp4r/8/8/8/7k w - c6 0 1",
+            "8/8/8/8/k2Pp2Q/8/8/3K4 b - d3 0 1",
+            "4k3/8/8/2Pp4/8/8/8/4K2b w - d6 0 1",
+            "3k4/3r4/8/8/8/8/3B4/3K4 w - - 0 1",
+            "4k3/8/8/8/1b6/8/3N4/4K2r w - - 0 1",
+            "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"
+        };
+        u8 p, ok = 1;
+        u32 legal_nodes;
+
+        for (p = 0; p < 6; p++) {
+            board_set_fen(fens[p]);
+            nodes = perft(3, 0);
+            legal_nodes = perft_legal(3, 0);
+            if (nodes != legal_nodes) {
+                printf("    %s: %lu vs %lu\n", fens[p],
+                       (unsigned long)nodes, (unsigned long)legal_nodes);
+                ok = 0;
+            }
+        }
+        TEST_ASSERT(ok, "Legal generator matches make-and-test on pin/ep positions");
+    }
+
+    /* Check evasions match the legal moves in every in-check node */
+    {
+        static const char *fens[5] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            "8/8/8/2k5/3Pp3/8/8/4K2B b - d3 0 1"
+        };
+        u8 p;
+        evasions_ok = 1;
+        evasion_nodes = 0;
+        for (p = 0; p < 5; p++) {
+            board_set_fen(fens[p]);
+            check_evasions(p == 1 ? 5 : 3, 0);
+        }
+        sprintf(msg, "Evasions match legal moves in %lu in-check nodes",
+                (unsigned long)evasion_nodes);
+        TEST_ASSERT(evasions_ok && evasion_nodes > 1000, msg);
+    }
+
+    /* gives_check: direct, discovered, promotion, castling and ep checks */
+    {
+        static const char *fens[5] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            "5k2/8/8/8/8/8/8/4K2R w K - 0 1"
+        };
+        u8 p;
+        gives_check_ok = 1;
+        for (p = 0; p < 5; p++) {
+            board_set_fen(fens[p]);
+            check_gives_check(p == 1 ? 4 : 3, 0);
+        }
+        TEST_ASSERT(gives_check_ok, "board_gives_check agrees with make-and-test");
+    }
+
+    /* Quiet checks: Ra8 directly, and each of the eight Nd4 moves
+     * discovers Bb2; Rh1 is blocked by the king */
+    board_set_fen("7k/8/8/8/3N4/8/1B6/R3K3 w Q - 0 1");
+    nodes = movegen_generate_quiet_checks(0);
+    sprintf(msg, "Quiet checks = %lu (expected 9)", (unsigned long)nodes);
+    TEST_ASSERT(nodes == 9, msg);
+
+    /* Counting legal moves without generating them */
+    {
+        static const char *fens[7] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            "8/8/8/2k5/3Pp3/8/8/4K2B b - d3 0 1",
+            "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",       /* stalemate */
+            "6rk/5Npp/8/8/8/8/8/6K1 b - - 0 1"      /* smothered mate */
+        };
+        u8 p;
+        count_legal_ok = 1;
+        for (p = 0; p < 7; p++) {
+            board_set_fen(fens[p]);
+            g_state.move_buf_idx[0] = 0;
+            check_count_legal(p < 5 ? 3 : 1, 0);
+        }
+        TEST_ASSERT(count_legal_ok, "movegen_count_legal matches the legal generator");
+    }
+
+    /* Pseudo-legality of moves from elsewhere (TT, killers) */
+    {
+        static const char *fens[5] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            "8/8/8/2k5/3Pp3/8/8/4K2B b - d3 0 1"
+        };
+        u8 p;
+        pseudo_legal_ok = 1;
+        for (p = 0; p < 5; p++) {
+            board_set_fen(fens[p]);
+            g_state.move_buf_idx[0] = 0;
+            check_pseudo_legal(2, 0);
+        }
+        TEST_ASSERT(pseudo_legal_ok,
+                    "board_is_pseudo_legal / movegen_is_legal match generated moves");
+    }
+
+    /* Staged move picker */
+    {
+        static const char *fens[4] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            "8/8/8/2k5/3Pp3/8/8/4K2B b - d3 0 1",
+            "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+        };
+        Move tt_ok, tt_bad;
+        u8 p, ok = 1;
+
+        for (p = 0; p < 4; p++) {
+            board_set_fen(fens[p]);
+            g_state.move_buf_idx[1] = 0;
+            movegen_generate_legal(1);
+            tt_ok = g_state.move_buf[g_state.move_buf_idx[1]];
+            tt_bad = MOVE_PACK(SQ_MAKE(3, 3), SQ_MAKE(7, 7), MF_NONE); /* d4h8: never legal here */
+            /* Killers: the last legal move if quiet, and a bogus one */
+            movesort_clear_killers();
+            movesort_update_killers(2, tt_bad);
+            movesort_update_killers(2, g_state.move_buf[g_state.move_buf_idx[2] - 1]);
+            if (!picker_matches_legal(NULL) || !picker_matches_legal(&tt_ok) ||
+                !picker_matches_legal(&tt_bad)) {
+                ok = 0;
+            }
+        }
+        TEST_ASSERT(ok, "Move picker yields each legal move once, valid TT move first");
+        movesort_clear_killers();
+    }
+
+#ifndef TARGET_C64
+    /* History ordering: a rewarded quiet comes first, the quiet tried
+     * before it (penalized) last */
+    {
+        MovePicker mp;
+        Move good = MOVE_PACK(SQ_MAKE(0, 6), SQ_MAKE(2, 5), MF_NONE);   /* g1f3 */
+        Move bad = MOVE_PACK(SQ_MAKE(1, 0), SQ_MAKE(2, 0), MF_NONE);    /* a2a3 */
+        Move m, first = MOVE_NONE, last = MOVE_NONE;
+
+        board_init();
+        movesort_clear_killers();
+        movesort_clear_history();
+        g_state.move_buf_idx[1] = 0;
+        movesort_update_quiet_stats(1, good, &bad, 1, 6);
+        movepicker_init(&mp, 1, NULL, 0);
+        while (movepicker_next(&mp, &m)) {
+            if (IS_MOVE_NONE(first)) first = m;
+            last = m;
+        }
+        TEST_ASSERT(first == good && last == bad,
+                    "History orders a cutoff move first and a failed quiet last");
+        movesort_clear_history();
+    }
+    {
+        u8 d, ok = 1;
+        for (d = 1; d < MAX_PLY; d++) {
+            if (movesort_history_bonus(d) < movesort_history_bonus((u8)(d - 1))) ok = 0;
+        }
+        TEST_ASSERT(ok, "History bonus never decreases with depth");
+    }
+#endif
+
+    /* Static exchange evaluation */
+    {
+        static const char *fens[5] = {
+            "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1",
+            "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+            "4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1",
+            "3rk3/8/8/3p4/8/8/3R4/3RK3 w - - 0 1",     /* rook battery x-ray */
+            "4k3/8/8/3pP3/8/8/8/3RK3 w - d6 0 1"
+        };
+        static const u8 from[5] = { 0x04, 0x23, 0x03, 0x13, 0x44 };
+        static const u8 to[5]   = { 0x44, 0x44, 0x43, 0x43, 0x53 };
+        static const u8 flags[5] = { MF_CAPTURE, MF_CAPTURE, MF_CAPTURE,
+                                     MF_CAPTURE, MF_CAPTURE | MF_EP };
+        static const s16 expected[5] = { 100, -225, -800, 100, 100 };
+        s16 value;
+        u16 i, n;
+        u8 p, ok = 1;
+
+        for (p = 0; p < 5; p++) {
+            board_set_fen(fens[p]);
+            value = see(MOVE_PACK(from[p], to[p], flags[p]));
+            if (value != expected[p]) {
+                printf("    %s: see = %d (expected %d)\n", fens[p], value, expected[p]);
+                ok = 0;
+            }
+        }
+        TEST_ASSERT(ok, "see() on exchanges with x-rays and en passant");
+
+        /* see_ge's shortcuts agree with the full exchange */
+        ok = 1;
+        board_set_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+        g_state.move_buf_idx[0] = 0;
+        n = movegen_generate(0);
+        for (i = 0; i < n; i++) {
+            Move m = g_state.move_buf[i];
+            value = see(m);
+            if (see_ge(m, -100) != (value >= -100) || see_ge(m, 0) != (value >= 0) ||
+                see_ge(m, 100) != (value >= 100)) {
+                ok = 0;
+            }
+        }
+        TEST_ASSERT(ok, "see_ge agrees with see on Kiwipete");
+    }
 }
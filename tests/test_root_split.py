@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Tests for scripts/root_split.py: the coordinator's iteration logic with
+scripted workers, then a smoke test with two real engine workers.
+
+Usage (after 'make pc'):
+    python tests/test_root_split.py [--engine build/c64chess.exe]
+"""
+
+import argparse
+import contextlib
+import io
+import os
+import shlex
+import subprocess
+import sys
+import unittest
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sys.path.insert(0, os.path.join(ROOT, "scripts"))
+
+import root_split  # noqa: E402
+
+ENGINE = os.path.join(ROOT, "build", "c64chess.exe")
+
+
+class ScriptedWorker:
+    """Stands in for an engine process: fixed scores per (move, depth)"""
+
+    def __init__(self, moves, scores):
+        self.moves = moves
+        self.scores = scores
+        self.searched = []
+
+    def root_moves(self, position):
+        return list(self.moves)
+
+    def search(self, position, move, depth, movetime):
+        self.searched.append((move, depth))
+        return depth, self.scores[(move, depth)], 1, [move]
+
+
+def run_go(worker, depth):
+    coordinator = root_split.Coordinator.__new__(root_split.Coordinator)
+    coordinator.workers = [worker]
+    coordinator.position = "position startpos"
+    out = io.StringIO()
+    with contextlib.redirect_stdout(out):
+        coordinator.go(depth, None)
+    return out.getvalue().split("\n")
+
+
+class CoordinatorTest(unittest.TestCase):
+    def test_best_move_is_searched_at_reported_depth(self):
+        # b falls out of the window after depth 1 and is not searched at
+        # depth 2, where a drops below b's old score
+        worker = ScriptedWorker(["a", "b"], {
+            ("a", 1): 100, ("b", 1): -500,
+            ("a", 2): -600,
+        })
+        lines = run_go(worker, 2)
+        self.assertNotIn(("b", 2), worker.searched)
+        self.assertTrue(lines[1].startswith("info depth 2 score cp -600 "))
+        self.assertTrue(lines[1].endswith(" pv a"))
+        self.assertIn("bestmove a", lines)
+
+    def test_skipped_move_returns_when_best_drops(self):
+        worker = ScriptedWorker(["a", "b"], {
+            ("a", 1): 100, ("b", 1): -500,
+            ("a", 2): -600,
+            ("a", 3): -600, ("b", 3): -400,
+        })
+        lines = run_go(worker, 3)
+        self.assertIn(("b", 3), worker.searched)
+        self.assertIn("bestmove b", lines)
+
+
+class TwoWorkerSmokeTest(unittest.TestCase):
+    def test_search_over_two_workers(self):
+        cmd = shlex.split(ENGINE)
+        if len(cmd) == 1 and not os.path.exists(cmd[0]):
+            self.skipTest("%s not built" % ENGINE)
+        proc = subprocess.run(
+            [sys.executable, os.path.join(ROOT, "scripts", "root_split.py"),
+             "--workers", "2", "--engine", ENGINE],
+            input="uci\nisready\nposition startpos moves e2e4\ngo depth 3\nquit\n",
+            stdout=subprocess.PIPE, universal_newlines=True, timeout=60, cwd=ROOT)
+        lines = proc.stdout.split("\n")
+        self.assertEqual(proc.returncode, 0)
+        self.assertIn("readyok", lines)
+        self.assertTrue(any(l.startswith("info depth 3 ") for l in lines))
+        best = [l.split()[1] for l in lines if l.startswith("bestmove")]
+        self.assertEqual(len(best), 1)
+
+        worker = root_split.Worker(cmd)
+        try:
+            replies = worker.root_moves("position startpos moves e2e4")
+        finally:
+            worker.quit()
+        self.assertIn(best[0], replies)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Root-split coordinator tests")
+    parser.add_argument("--engine", default=ENGINE, help="Worker command line")
+    args, rest = parser.parse_known_args()
+    ENGINE = args.engine
+    unittest.main(argv=[sys.argv[0]] + rest)
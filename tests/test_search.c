@@ -3,6 +3,7 @@
  * - Mate-in-1 puzzles
  * - Mate-in-2 puzzles
  * - Tactical puzzles (win material)
+ * - Transposition table key verification
  */
 
 #include <stdio.h>
@@ -13,6 +14,9 @@
 #include "../src/eval.h"
 #include "../src/tt.h"
 #include "../src/tables.h"
+#include "../src/engine.h"
+#include "../src/movesort.h"
+#include "../src/uci/uci.h"
 
 extern int tests_run, tests_passed, tests_failed;
 
@@ -31,16 +35,16 @@ static u8 finds_move(const char *fen, u8 depth,
     tt_clear();
     result = search_position(depth, 0);
 
-    if (result.best_move.from == exp_from &&
-        result.best_move.to == exp_to) {
+    if (MOVE_FROM(result.best_move) == exp_from &&
+        MOVE_TO(result.best_move) == exp_to) {
         return 1;
     }
 
     /* Print what was found for debugging */
     {
         char from_str[3], to_str[3], exp_from_str[3], exp_to_str[3];
-        sq_to_str(result.best_move.from, from_str);
-        sq_to_str(result.best_move.to, to_str);
+        sq_to_str(MOVE_FROM(result.best_move), from_str);
+        sq_to_str(MOVE_TO(result.best_move), to_str);
         sq_to_str(exp_from, exp_from_str);
         sq_to_str(exp_to, exp_to_str);
         printf("    Expected %s%s, got %s%s (score %d)\n",
@@ -145,4 +149,178 @@ void test_search(void) {
         s16 score = eval_position();
         TEST_ASSERT(score < -800, "Black with extra queen, white to move has low eval");
     }
+
+#ifndef TARGET_C64
+    /* --- TT verification --- */
+    printf("  Transposition table tests...\n");
+
+    /* Keys differing only above the index bits share a slot but must
+     * not be mistaken for each other */
+    board_init();
+    tt_clear();
+    {
+        HashKey h = g_state.hash;
+        HashKey alias = h ^ ((HashKey)1 << 40);
+        Move m, got;
+        s16 score = 0;
+        m = MOVE_PACK(SQ_MAKE(1, 4), SQ_MAKE(3, 4), MF_PAWNSTART);
+        tt_store(h, 5, 42, TT_FLAG_EXACT, m, 0);
+        TEST_ASSERT(tt_probe(h, 5, -100, 100, &score, &got, 0) && score == 42,
+                    "TT hit on the stored 64-bit key");
+        TEST_ASSERT(!tt_probe(alias, 5, -100, 100, &score, &got, 0),
+                    "TT rejects key aliasing the same slot");
+    }
+
+    /* A lower bound too shallow for a cutoff still shows its depth,
+     * bound and raw score */
+    {
+        HashKey h = g_state.hash;
+        Move m = MOVE_PACK(SQ_MAKE(0, 6), SQ_MAKE(2, 5), MF_NONE);
+        TTHit hit;
+        s16 score = 0;
+
+        tt_store(h, 4, 250, TT_FLAG_BETA, m, 0);
+        TEST_ASSERT(tt_probe_entry(h, 0, &hit) && hit.best_move == m &&
+                    hit.depth == 4 && hit.flag == TT_FLAG_BETA && hit.score == 250 &&
+                    !tt_cutoff(&hit, 6, -100, 100, &score) &&
+                    tt_cutoff(&hit, 4, -100, 100, &score) && score == 100,
+                    "TT entry exposes depth, bound and score");
+    }
+
+    /* --- UCI go --- */
+    printf("  UCI go tests...\n");
+    {
+        static UciGo go;
+        static const char *fens[4] = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+        };
+        static const u32 perft3[4] = { 8902, 97862, 2812, 9467 };
+        SearchResult res;
+        TTHit hit;
+        u8 p, ok = 1;
+
+        /* The move list ends at the next keyword, which is still read */
+        board_init();
+        uci_parse_go(" searchmoves e2e4 g1f3 wtime 1000 btime 900 depth 3", &go);
+        TEST_ASSERT(go.root_count == 2 &&
+                    MOVE_FROM(go.root_moves[0]) == SQ_MAKE(1, 4) &&
+                    MOVE_TO(go.root_moves[1]) == SQ_MAKE(2, 5) &&
+                    go.wtime == 1000 && go.btime == 900 && go.depth == 3,
+                    "go searchmoves list stops at the next keyword");
+
+        /* Left out of searchmoves, the mate is not played, and the
+         * restricted root score is not stored in the TT */
+        board_set_fen("6k1/5ppp/8/8/8/8/8/R3K3 w Q - 0 1");
+        tt_clear();
+        uci_parse_go(" depth 4 searchmoves e1e2 e1d2", &go);
+        search_set_info_output(0);
+        search_set_root_moves(go.root_moves, go.root_count);
+        res = search_position(go.depth, 0);
+        search_set_root_moves(NULL, 0);
+        search_set_info_output(1);
+        TEST_ASSERT(MOVE_FROM(res.best_move) == SQ_MAKE(0, 4) &&
+                    !tt_probe_entry(g_state.hash, 0, &hit),
+                    "go searchmoves limits the root moves, root not in TT");
+        /* With no TT move there, the root is still searched to the
+         * full depth it reports (no internal iterative reduction) */
+        TEST_ASSERT(res.depth == 4 && g_search_info.root_depth == 4,
+                    "Root without a TT move is searched to the full depth");
+
+        for (p = 0; p < 4; p++) {
+            board_set_fen(fens[p]);
+            uci_parse_go(" perft 3", &go);
+            if (go.perft != 3 || uci_perft(go.perft, 0) != perft3[p]) ok = 0;
+        }
+        TEST_ASSERT(ok, "go perft 3 counts match the perft positions");
+    }
+
+    /* --- Engine contexts --- */
+    printf("  Engine context tests...\n");
+    {
+        Engine *a, *b;
+        HashKey main_hash;
+        Move m = MOVE_PACK(SQ_MAKE(1, 3), SQ_MAKE(3, 3), MF_PAWNSTART);
+        Move got = MOVE_NONE;
+        s16 score;
+        SearchResult res;
+
+        board_set_fen("r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3");
+        main_hash = g_state.hash;
+
+        /* A searches its own position; the main engine's is untouched */
+        a = engine_create(NULL);
+        b = engine_create(a);
+        engine_set_current(a);
+        res = search_position(4, 0);
+        engine_set_current(NULL);
+        TEST_ASSERT(a && b && !IS_MOVE_NONE(res.best_move) &&
+                    g_state.hash == main_hash && g_state.hash == board_compute_hash(),
+                    "Engines search independently of the main engine");
+
+        /* B shares A's table, the main engine does not */
+        engine_set_current(a);
+        tt_store(g_state.hash, 3, 17, TT_FLAG_EXACT, m, 0);
+        engine_set_current(b);
+        TEST_ASSERT(tt_probe(g_state.hash, 3, -100, 100, &score, &got, 0) && got == m,
+                    "Engine shares the TT it was created with");
+        engine_set_current(NULL);
+        board_init();
+        TEST_ASSERT(!tt_probe(g_state.hash, 3, -100, 100, &score, &got, 0) ||
+                    score != 17, "Main engine keeps its own TT");
+
+        engine_destroy(b);
+        engine_destroy(a);
+    }
+
+    /* --- Lazy SMP --- */
+    printf("  Multithreaded search tests...\n");
+    TEST_ASSERT(search_set_threads(4) == 4, "Threads option takes 4 threads");
+    TEST_ASSERT(finds_move("6k1/5ppp/8/8/8/8/8/R3K3 w Q - 0 1",
+                           5, SQ_MAKE(0, 0), SQ_MAKE(7, 0)),
+                "4 threads find the back rank mate");
+    search_set_threads(1);
+
+    /* Helpers belong to their engine: another engine's thread count and
+     * search leave the main engine's alone */
+    {
+        Engine *a = engine_create(NULL);
+        u8 found;
+
+        engine_set_current(a);
+        search_set_threads(3);
+        found = finds_move("6k1/5ppp/8/8/8/8/8/R3K3 w Q - 0 1",
+                           5, SQ_MAKE(0, 0), SQ_MAKE(7, 0));
+        engine_set_current(NULL);
+        TEST_ASSERT(a && found && a->helper_count == 2 &&
+                    g_engine_main.helper_count == 0,
+                    "Each engine has its own helper threads");
+
+        /* So are the pruning switches, which its helpers search with */
+        engine_set_current(a);
+        search_set_pruning(PRUNE_ALL & ~PRUNE_LMP);
+        finds_move("6k1/5ppp/8/8/8/8/8/R3K3 w Q - 0 1",
+                   3, SQ_MAKE(0, 0), SQ_MAKE(7, 0));
+        found = (search_get_pruning() == (PRUNE_ALL & ~PRUNE_LMP));
+        engine_set_current(NULL);
+        TEST_ASSERT(found && search_get_pruning() == PRUNE_ALL &&
+                    a->helpers[0]->pruning_off == PRUNE_LMP,
+                    "Pruning switches are per engine and reach its helpers");
+
+        /* A new game forgets the helpers' move ordering too */
+        a->helpers[1]->history[WHITE][SQ_INDEX64(SQ_MAKE(0, 0))]
+                              [SQ_INDEX64(SQ_MAKE(7, 0))] = 500;
+        a->helpers[1]->countermoves[0] = MOVE_PACK(SQ_MAKE(0, 0), SQ_MAKE(7, 0), MF_NONE);
+        engine_set_current(a);
+        movesort_clear_history();
+        engine_set_current(NULL);
+        TEST_ASSERT(a->helpers[1]->history[WHITE][SQ_INDEX64(SQ_MAKE(0, 0))]
+                                                 [SQ_INDEX64(SQ_MAKE(7, 0))] == 0 &&
+                    a->helpers[1]->countermoves[0] == MOVE_NONE,
+                    "Clearing history clears the helper engines");
+        engine_destroy(a);
+    }
+#endif
 }